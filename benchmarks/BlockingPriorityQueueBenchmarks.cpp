@@ -0,0 +1,55 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "BlockingPriorityQueue.hpp"
+#include "warningDisable.h"
+
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <thread>
+
+using gmlc::containers::BlockingPriorityQueue;
+
+namespace {
+
+/** measure the cost of pushPriority while another thread keeps a normal lane
+backlog of state.range(0) elements cycling through the swap in the consumer*/
+void bmPriorityPushWithBacklog(benchmark::State& state)
+{
+    BlockingPriorityQueue<int64_t> queue;
+    const int64_t backlog = state.range(0);
+    queue.reserve(static_cast<std::size_t>(backlog) + 1);
+    std::atomic<bool> running{true};
+    std::thread churn([&]() {
+        while (running.load()) {
+            for (int64_t ii = 0; ii < backlog; ++ii) {
+                queue.push(ii);
+            }
+            // the first pop after the batch swaps and reverses the backlog
+            while (queue.try_pop()) {
+            }
+        }
+    });
+    int64_t value{0};
+    for (auto iteration : state) {
+        (void)iteration;
+        queue.pushPriority(++value);
+    }
+    running.store(false);
+    churn.join();
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(bmPriorityPushWithBacklog)
+    ->Arg(0)
+    ->Arg(10'000)
+    ->Arg(1'000'000)
+    ->UseRealTime()
+    ->Unit(benchmark::kNanosecond);
@@ -0,0 +1,345 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "WorkQueue.hpp"
+#include "warningDisable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using gmlc::containers::make_shared_workBlock;
+using gmlc::containers::WorkQueue;
+
+namespace {
+constexpr int fanCount{10'000};
+
+int hardwareThreads()
+{
+    return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+/** a small amount of work standing in for a real task*/
+void busyWork(std::int64_t iterations)
+{
+    std::uint64_t value{0x9E3779B97F4A7C15ULL};
+    for (std::int64_t ii = 0; ii < iterations; ++ii) {
+        value ^= value << 13U;
+        value ^= value >> 7U;
+        value ^= value << 17U;
+    }
+    benchmark::DoNotOptimize(value);
+}
+
+/** wait until a counter reaches a value*/
+void waitFor(const std::atomic<int>& counter, int target)
+{
+    while (counter.load(std::memory_order_acquire) < target) {
+        std::this_thread::yield();
+    }
+}
+
+void workerArgs(benchmark::internal::Benchmark* bench)
+{
+    for (int workers = 1; workers <= hardwareThreads(); workers *= 2) {
+        bench->Arg(workers);
+    }
+    if ((hardwareThreads() & (hardwareThreads() - 1)) != 0) {
+        bench->Arg(hardwareThreads());
+    }
+}
+
+/** submission throughput of empty fire and forget tasks*/
+void bmSubmitAddTask(benchmark::State& state)
+{
+    WorkQueue queue(static_cast<int>(state.range(0)));
+    std::atomic<int> done{0};
+    for (auto iteration : state) {
+        (void)iteration;
+        done.store(0);
+        for (int ii = 0; ii < fanCount; ++ii) {
+            queue.addTask(
+                [&done] { done.fetch_add(1, std::memory_order_release); });
+        }
+        waitFor(done, fanCount);
+    }
+    state.SetItemsProcessed(state.iterations() * fanCount);
+}
+
+void bmSubmitAddBatchedTask(benchmark::State& state)
+{
+    WorkQueue queue(static_cast<int>(state.range(0)));
+    std::atomic<int> done{0};
+    for (auto iteration : state) {
+        (void)iteration;
+        done.store(0);
+        for (int ii = 0; ii < fanCount; ++ii) {
+            queue.addBatchedTask(
+                [&done] { done.fetch_add(1, std::memory_order_release); });
+        }
+        queue.flushBatches();
+        waitFor(done, fanCount);
+    }
+    state.SetItemsProcessed(state.iterations() * fanCount);
+}
+
+void bmSubmitWorkBlock(benchmark::State& state)
+{
+    WorkQueue queue(static_cast<int>(state.range(0)));
+    std::atomic<int> done{0};
+    for (auto iteration : state) {
+        (void)iteration;
+        done.store(0);
+        for (int ii = 0; ii < fanCount; ++ii) {
+            queue.addWorkBlock(make_shared_workBlock(
+                [&done] { done.fetch_add(1, std::memory_order_release); }));
+        }
+        waitFor(done, fanCount);
+    }
+    state.SetItemsProcessed(state.iterations() * fanCount);
+}
+
+/** round trip of a single empty task from submission to the waiting thread*/
+void bmRoundTripWorkQueue(benchmark::State& state)
+{
+    WorkQueue queue(1);
+    for (auto iteration : state) {
+        (void)iteration;
+        auto block = make_shared_workBlock([] { return 1; });
+        queue.addWorkBlock(block, WorkQueue::WorkPriority::high);
+        benchmark::DoNotOptimize(block->getReturnVal());
+    }
+}
+
+void bmRoundTripAsync(benchmark::State& state)
+{
+    for (auto iteration : state) {
+        (void)iteration;
+        auto result = std::async(std::launch::async, [] { return 1; });
+        benchmark::DoNotOptimize(result.get());
+    }
+}
+
+/** fan out 10k small tasks and wait for all of them*/
+void bmFanOutWorkQueue(benchmark::State& state)
+{
+    WorkQueue queue(hardwareThreads());
+    const auto work = state.range(0);
+    std::atomic<int> done{0};
+    for (auto iteration : state) {
+        (void)iteration;
+        done.store(0);
+        for (int ii = 0; ii < fanCount; ++ii) {
+            queue.addTask([&done, work] {
+                busyWork(work);
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        waitFor(done, fanCount);
+    }
+    state.SetItemsProcessed(state.iterations() * fanCount);
+}
+
+void bmFanOutParallelFor(benchmark::State& state)
+{
+    WorkQueue queue(hardwareThreads());
+    const auto work = state.range(0);
+    for (auto iteration : state) {
+        (void)iteration;
+        queue.parallel_for(0, fanCount, 16, [work](int /*index*/) {
+            busyWork(work);
+        });
+    }
+    state.SetItemsProcessed(state.iterations() * fanCount);
+}
+
+/** a thread per task with at most one task per core running at a time*/
+void bmFanOutAsync(benchmark::State& state)
+{
+    const auto work = state.range(0);
+    std::vector<std::future<void>> results(
+        static_cast<std::size_t>(hardwareThreads()));
+    for (auto iteration : state) {
+        (void)iteration;
+        for (int ii = 0; ii < fanCount; ++ii) {
+            const auto slot = static_cast<std::size_t>(ii) % results.size();
+            auto& result = results[slot];
+            if (result.valid()) {
+                result.get();
+            }
+            result = std::async(std::launch::async, [work] { busyWork(work); });
+        }
+        for (auto& result : results) {
+            if (result.valid()) {
+                result.get();
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * fanCount);
+}
+
+/** one thread per core each running a static slice of the tasks*/
+void bmFanOutThreadPerCore(benchmark::State& state)
+{
+    const auto work = state.range(0);
+    const int threadCount = hardwareThreads();
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (auto iteration : state) {
+        (void)iteration;
+        for (int tt = 0; tt < threadCount; ++tt) {
+            threads.emplace_back([tt, threadCount, work] {
+                for (int ii = tt; ii < fanCount; ii += threadCount) {
+                    busyWork(work);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        threads.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * fanCount);
+}
+
+/** order in which queued medium and low priority work is executed*/
+void bmMixedPriority(benchmark::State& state)
+{
+    WorkQueue queue(1);
+    queue.setPriorityRatio(static_cast<int>(state.range(0)));
+    constexpr int perPriority{fanCount / 2};
+    std::vector<char> order;
+    order.reserve(fanCount);
+    double ratio{0.0};
+    for (auto iteration : state) {
+        (void)iteration;
+        state.PauseTiming();
+        order.clear();
+        std::promise<void> gate;
+        auto blocker = make_shared_workBlock(
+            [started = gate.get_future().share()] { started.wait(); });
+        queue.addWorkBlock(blocker, WorkQueue::WorkPriority::high);
+        while (!queue.isEmpty()) {
+            std::this_thread::yield();
+        }
+        for (int ii = 0; ii < perPriority; ++ii) {
+            queue.addTask(
+                [&order] { order.push_back('m'); },
+                WorkQueue::WorkPriority::medium);
+            queue.addTask(
+                [&order] { order.push_back('l'); },
+                WorkQueue::WorkPriority::low);
+        }
+        auto last = make_shared_workBlock([] {});
+        queue.addWorkBlock(last, WorkQueue::WorkPriority::low);
+        state.ResumeTiming();
+        gate.set_value();
+        last->wait();
+        state.PauseTiming();
+        // the ratio while both priorities were queued
+        int medium{0};
+        int low{0};
+        for (auto entry : order) {
+            if (entry == 'm') {
+                if (++medium == perPriority) {
+                    break;
+                }
+            } else {
+                ++low;
+            }
+        }
+        ratio = static_cast<double>(medium) / std::max(low, 1);
+        state.ResumeTiming();
+    }
+    state.counters["medium_per_low"] = ratio;
+    state.SetItemsProcessed(state.iterations() * fanCount);
+}
+
+/** run a fixed amount of work on a queue with parallel_for*/
+void scalingRun(WorkQueue& queue, benchmark::State& state)
+{
+    for (auto iteration : state) {
+        (void)iteration;
+        queue.parallel_for(0, fanCount, 16, [](int /*index*/) {
+            busyWork(2000);
+        });
+    }
+    state.SetItemsProcessed(state.iterations() * fanCount);
+}
+
+/** a fixed amount of work spread over 1 to N workers*/
+void bmScalingWorkQueue(benchmark::State& state)
+{
+    WorkQueue queue(static_cast<int>(state.range(0)));
+    scalingRun(queue, state);
+}
+
+void bmScalingWorkStealing(benchmark::State& state)
+{
+    WorkQueue queue(
+        static_cast<int>(state.range(0)),
+        WorkQueue::SchedulingMode::workStealing);
+    scalingRun(queue, state);
+}
+
+}  // namespace
+
+BENCHMARK(bmSubmitAddTask)->Apply(workerArgs)->UseRealTime();
+
+BENCHMARK(bmSubmitAddBatchedTask)->Apply(workerArgs)->UseRealTime();
+
+BENCHMARK(bmSubmitWorkBlock)->Apply(workerArgs)->UseRealTime();
+
+BENCHMARK(bmRoundTripWorkQueue)->UseRealTime();
+
+BENCHMARK(bmRoundTripAsync)->UseRealTime();
+
+BENCHMARK(bmFanOutWorkQueue)
+    ->Arg(0)
+    ->Arg(1000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(bmFanOutParallelFor)
+    ->Arg(0)
+    ->Arg(1000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(bmFanOutAsync)
+    ->Arg(0)
+    ->Arg(1000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(bmFanOutThreadPerCore)
+    ->Arg(0)
+    ->Arg(1000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(bmMixedPriority)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(bmScalingWorkQueue)
+    ->Apply(workerArgs)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(bmScalingWorkStealing)
+    ->Apply(workerArgs)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
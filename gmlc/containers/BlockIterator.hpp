@@ -22,7 +22,7 @@ class BlockIterator {
     int offset;
 
   public:
-    using iterator_category = std::bidirectional_iterator_tag;
+    using iterator_category = std::random_access_iterator_tag;
     using value_type = X;
     using difference_type = std::ptrdiff_t;
     using pointer =
@@ -72,6 +72,9 @@ class BlockIterator {
 
     BlockIterator& operator+=(const ptrdiff_t& movement)
     {
+        if (movement < 0) {
+            return operator-=(-movement);
+        }
         ptr += movement;
         offset += static_cast<int>(movement);
         check();
@@ -98,6 +101,9 @@ class BlockIterator {
     }
     BlockIterator& operator-=(const ptrdiff_t& movement)
     {
+        if (movement < 0) {
+            return operator+=(-movement);
+        }
         ptr -= movement;
         offset -= static_cast<int>(movement);
         checkNeg();
@@ -122,6 +128,31 @@ class BlockIterator {
         temp -= movement;
         return temp;
     }
+    friend BlockIterator
+        operator+(const ptrdiff_t& movement, const BlockIterator& it)
+    {
+        return it + movement;
+    }
+    /// the number of elements between two iterators of the same container
+    difference_type operator-(const BlockIterator& it) const
+    {
+        return (vec - it.vec) * BLOCKSIZE + (offset - it.offset);
+    }
+    X& operator[](const ptrdiff_t& index) { return *(*this + index); }
+    constref& operator[](const ptrdiff_t& index) const
+    {
+        return *(*this + index);
+    }
+    bool operator<(const BlockIterator& it) const { return (*this - it) < 0; }
+    bool operator>(const BlockIterator& it) const { return (*this - it) > 0; }
+    bool operator<=(const BlockIterator& it) const
+    {
+        return (*this - it) <= 0;
+    }
+    bool operator>=(const BlockIterator& it) const
+    {
+        return (*this - it) >= 0;
+    }
     template<typename OUTER2>
     bool checkEquivalence(OUTER2 testv, int testoffset) const
     {
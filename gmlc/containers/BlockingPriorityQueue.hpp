@@ -12,9 +12,12 @@ SPDX-License-Identifier: BSD-3-Clause
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -24,7 +27,12 @@ namespace gmlc::containers {
 /** class implementing a blocking queue with a priority channel
 @details this class uses locks one for push and pull it can exhibit longer
 blocking times if the internal operations require a swap, however in high usage
-the two locks will reduce contention in most cases.
+the two locks will reduce contention in most cases.  The priority channel has
+its own lock which is never held while acquiring another lock, so priority
+pushes do not wait on a consumer that is swapping a large normal backlog. The
+lock order is pull -> push -> priority.  Consumers that have to block park in
+a slot guarded by the priority lock so a priority push can hand its element
+directly to a waiting consumer without touching the queue structures.
 */
 template<
     typename T,
@@ -35,13 +43,33 @@ class BlockingPriorityQueue {
     mutable MUTEX m_pushLock;  //!< lock for operations on the pushElements
                                //!< vector
     mutable MUTEX m_pullLock;  //!< lock for elements on the pullLock vector
+    mutable MUTEX m_priorityLock;  //!< lock for the priority channel
     std::vector<T> pushElements;  //!< vector of elements being added
     std::vector<T> pullElements;  //!< vector of elements waiting extraction
     std::atomic<bool> queueEmptyFlag{
-        true};  //!< flag indicating the queue is empty
-    std::queue<T> priorityQueue;  //!< the priority channel
-    // the condition variable should be keyed of the pullLock
-    COND condition;  //!< condition variable for notification of new data
+        true};  //!< flag indicating the normal lane is empty
+    std::deque<T> priorityQueue;  //!< the priority channel
+    std::atomic<std::size_t> priorityCount{
+        0};  //!< number of elements in the priority channel
+    std::atomic<int> priorityRatio{0};  //!< max consecutive priority pops
+                                        //!< before a normal element is
+                                        //!< served (0 for strict priority)
+    std::atomic<int> priorityStreak{
+        0};  //!< priority pops since the last normal pop
+    std::atomic<std::uint64_t> fairnessCount{
+        0};  //!< number of times the normal lane was served ahead of
+             //!< waiting priority elements
+    /** the channels a parked consumer will accept elements from*/
+    enum class Lane { any, priority, normal };
+    /** parking slot for a consumer blocked in one of the pop calls*/
+    struct WaitSlot {
+        std::optional<T> value;  //!< element handed directly to the consumer
+        COND condition;  //!< condition variable keyed off m_priorityLock
+        Lane lane{Lane::any};  //!< the channels the consumer is waiting on
+        bool signaled{false};  //!< set when the slot was removed by a producer
+    };
+    std::vector<WaitSlot*>
+        waiters;  //!< parked consumers, guarded by m_priorityLock
   public:
     /** default constructor*/
     BlockingPriorityQueue() = default;
@@ -51,11 +79,12 @@ class BlockingPriorityQueue {
     {
         std::lock_guard<MUTEX> pullLock(m_pullLock);  // first pullLock
         std::lock_guard<MUTEX> pushLock(m_pushLock);  // second pushLock
+        std::lock_guard<MUTEX> priorityLock(m_priorityLock);
         pullElements.clear();
         pushElements.clear();
-        while (!priorityQueue.empty()) {
-            priorityQueue.pop();
-        }
+        priorityQueue.clear();
+        priorityCount = 0;
+        priorityStreak = 0;
         queueEmptyFlag = true;
     }
 
@@ -74,9 +103,13 @@ so the actual reserve is 2x the capacity numbers in two different vectors
     BlockingPriorityQueue(BlockingPriorityQueue&& bq) noexcept :
         pushElements(std::move(bq.pushElements)),
         pullElements(std::move(bq.pullElements)),
-        priorityQueue(std::move(bq.priorityQueue))
+        priorityQueue(std::move(bq.priorityQueue)),
+        priorityRatio(bq.priorityRatio.load()),
+        priorityStreak(bq.priorityStreak.load()),
+        fairnessCount(bq.fairnessCount.load())
     {
-        queueEmptyFlag = (pullElements.empty() && priorityQueue.empty());
+        priorityCount = priorityQueue.size();
+        queueEmptyFlag = pullElements.empty();
     }
 
     /** enable the move assignment not the copy assignment*/
@@ -84,10 +117,15 @@ so the actual reserve is 2x the capacity numbers in two different vectors
     {
         std::lock_guard<MUTEX> pullLock(m_pullLock);  // first pullLock
         std::lock_guard<MUTEX> pushLock(m_pushLock);  // second pushLock
+        std::lock_guard<MUTEX> priorityLock(m_priorityLock);
         pushElements = std::move(sq.pushElements);
         pullElements = std::move(sq.pullElements);
         priorityQueue = std::move(sq.priorityQueue);
-        queueEmptyFlag = (pullElements.empty() && priorityQueue.empty());
+        priorityCount = priorityQueue.size();
+        queueEmptyFlag = pullElements.empty();
+        priorityRatio = sq.priorityRatio.load();
+        priorityStreak = sq.priorityStreak.load();
+        fairnessCount = sq.fairnessCount.load();
         return *this;
     }
     /** DISABLE_COPY_AND_ASSIGN */
@@ -107,6 +145,21 @@ two vectors internally
         pushElements.reserve(capacity);
     }
 
+    /** set the fairness ratio between the priority channel and the normal
+lane
+@details with a ratio of N, at most N consecutive elements are taken from the
+priority channel while the normal lane has elements waiting, after which one
+normal element is served
+@param newPriorityRatio the ratio to use, values <=0 restore strict priority
+*/
+    void setPriorityRatio(int newPriorityRatio)
+    {
+        priorityRatio = (newPriorityRatio > 0) ? newPriorityRatio : 0;
+    }
+    /** get the number of times the fairness ratio caused a normal element to
+be served while priority elements were waiting*/
+    std::uint64_t getFairnessCount() const { return fairnessCount.load(); }
+
     /** push an element onto the queue
 val the value to push on the queue
 */
@@ -130,13 +183,13 @@ val the value to push on the queue
                     pushLock.lock();
                     pushElements.push_back(std::forward<Z>(val));
                 }
-                condition.notify_all();
+                wakeConsumers();
                 return;
             } else {
                 pushElements.push_back(std::forward<Z>(val));
                 expEmpty = true;
                 if (queueEmptyFlag.compare_exchange_strong(expEmpty, false)) {
-                    condition.notify_all();
+                    wakeConsumers();
                 }
                 return;
             }
@@ -144,28 +197,24 @@ val the value to push on the queue
         pushElements.push_back(std::forward<Z>(val));
     }
 
-    /** push an element onto the queue
+    /** push an element onto the priority channel
+@details if a consumer is parked in one of the pop calls the element is
+handed directly to it and only that consumer is woken
 val the value to push on the queue
 */
     template<class Z>
     void pushPriority(Z&& val)  // forwarding reference
     {
-        bool expEmpty = true;
-        if (queueEmptyFlag.compare_exchange_strong(expEmpty, false)) {
-            std::unique_lock<MUTEX> pullLock(m_pullLock);  // first pullLock
-            queueEmptyFlag = false;  // need to set the flag again just in
-                                     // case after we get the lock
-            priorityQueue.push(std::forward<Z>(val));
-            // pullLock.unlock ();
-            condition.notify_all();
-        } else {
-            std::unique_lock<MUTEX> pullLock(m_pullLock);
-            priorityQueue.push(std::forward<Z>(val));
-            expEmpty = true;
-            if (queueEmptyFlag.compare_exchange_strong(expEmpty, false)) {
-                condition.notify_all();
+        std::lock_guard<MUTEX> priorityLock(m_priorityLock);
+        if (!waiters.empty()) {
+            WaitSlot* slot = handoff();
+            if (slot != nullptr) {
+                slot->value.emplace(std::forward<Z>(val));
+                return;
             }
         }
+        priorityQueue.push_back(std::forward<Z>(val));
+        ++priorityCount;
     }
 
     /** construct on object in place on the queue */
@@ -190,13 +239,13 @@ val the value to push on the queue
                     pushElements.emplace_back(std::forward<Args>(args)...);
                 }
 
-                condition.notify_all();
+                wakeConsumers();
                 return;
             } else {
                 pushElements.emplace_back(std::forward<Args>(args)...);
                 expEmpty = true;
                 if (queueEmptyFlag.compare_exchange_strong(expEmpty, false)) {
-                    condition.notify_all();
+                    wakeConsumers();
                 }
                 return;
             }
@@ -204,28 +253,22 @@ val the value to push on the queue
         pushElements.emplace_back(std::forward<Args>(args)...);
     }
 
-    /** emplace an element onto the priority queue
+    /** emplace an element onto the priority channel
 val the value to push on the queue
 */
     template<class... Args>
     void emplacePriority(Args&&... args)
     {
-        bool expEmpty = true;
-        if (queueEmptyFlag.compare_exchange_strong(expEmpty, false)) {
-            std::unique_lock<MUTEX> pullLock(m_pullLock);  // first pullLock
-            queueEmptyFlag = false;  // need to set the flag again just in
-                                     // case after we get the lock
-            priorityQueue.emplace(std::forward<Args>(args)...);
-            // pullLock.unlock ();
-            condition.notify_all();
-        } else {
-            std::unique_lock<MUTEX> pullLock(m_pullLock);
-            priorityQueue.emplace(std::forward<Args>(args)...);
-            expEmpty = true;
-            if (queueEmptyFlag.compare_exchange_strong(expEmpty, false)) {
-                condition.notify_all();
+        std::lock_guard<MUTEX> priorityLock(m_priorityLock);
+        if (!waiters.empty()) {
+            WaitSlot* slot = handoff();
+            if (slot != nullptr) {
+                slot->value.emplace(std::forward<Args>(args)...);
+                return;
             }
         }
+        priorityQueue.emplace_back(std::forward<Args>(args)...);
+        ++priorityCount;
     }
     /** try to peek at an object without popping it from the stack
 @details only available for copy assignable objects
@@ -237,8 +280,11 @@ val the value to push on the queue
     std::optional<T> try_peek() const
     {
         std::lock_guard<MUTEX> lock(m_pullLock);
-        if (!priorityQueue.empty()) {
-            return priorityQueue.front();
+        {
+            std::lock_guard<MUTEX> priorityLock(m_priorityLock);
+            if (!priorityQueue.empty()) {
+                return priorityQueue.front();
+            }
         }
         if (pullElements.empty()) {
             return std::nullopt;
@@ -257,46 +303,24 @@ empty if there is no element in the queue
     /** blocking call to wait on an object from the stack*/
     T pop()
     {
-        T actval;
         auto val = try_pop();
         while (!val) {
             std::unique_lock<MUTEX> pullLock(
                 m_pullLock);  // get the lock then wait
-            if (!priorityQueue.empty()) {
-                actval = std::move(priorityQueue.front());
-                priorityQueue.pop();
-                return actval;
-            }
             // Hold pull first, then transiently take push inside
             // checkPullAndSwap to preserve the class lock ordering.
-            checkPullAndSwap();
-            if (!pullElements.empty())  // make sure we are actually empty;
-            {
-                actval = std::move(pullElements.back());
-                pullElements.pop_back();
-                return actval;
-            }
-            condition.wait(pullLock);  // now wait
-            if (!priorityQueue.empty()) {
-                actval = std::move(priorityQueue.front());
-                priorityQueue.pop();
-                return actval;
+            val = popLocked();
+            if (val) {
+                break;
             }
-            // Re-run the same pull->push swap path after wake-up so
-            // pushElements data is visible before deciding to sleep again.
-            checkPullAndSwap();
-            if (!pullElements.empty())  // check for spurious wake-ups
-            {
-                actval = std::move(pullElements.back());
-                pullElements.pop_back();
-                return actval;
+            parkConsumer(pullLock, val, Lane::any);  // now wait
+            if (val) {
+                break;
             }
-            pullLock.unlock();
             val = try_pop();
         }
         // move the value out of the optional
-        actval = std::move(*val);
-        return actval;
+        return std::move(*val);
     }
 
     /** blocking call to wait on an object from the stack with timeout*/
@@ -307,37 +331,17 @@ empty if there is no element in the queue
         while (!val) {
             std::unique_lock<MUTEX> pullLock(
                 m_pullLock);  // get the lock then wait
-            if (!priorityQueue.empty()) {
-                val = std::move(priorityQueue.front());
-                priorityQueue.pop();
+            val = popLocked();
+            if (val) {
                 break;
             }
-            checkPullAndSwap();
-            if (!pullElements.empty())  // make sure we are actually empty;
-            {
-                val = std::move(pullElements.back());
-                pullElements.pop_back();
+            const bool noTimeout =
+                parkConsumer(pullLock, val, Lane::any, &timeout);  // now wait
+            if (val) {
                 break;
             }
-            auto res = condition.wait_for(pullLock, timeout);  // now wait
-
-            if (!priorityQueue.empty()) {
-                val = std::move(priorityQueue.front());
-                priorityQueue.pop();
-                break;
-            }
-            checkPullAndSwap();
-            if (!pullElements.empty())  // check for spurious wake-ups
-            {
-                val = std::move(pullElements.back());
-                pullElements.pop_back();
-                break;
-            }
-            pullLock.unlock();
             val = try_pop();
-            if (res !=
-                std::cv_status::no_timeout)  // std::cv_status::no_timeout
-            {
+            if (!noTimeout) {
                 break;
             }
         }
@@ -360,42 +364,145 @@ empty will block and wait.
             // may be spurious so make sure actually have a value
             callOnWaitFunction();
             std::unique_lock<MUTEX> pullLock(m_pullLock);  // first pullLock
-            if (!priorityQueue.empty()) {
-                auto actval = std::move(priorityQueue.front());
-                priorityQueue.pop();
-                return actval;
+            // the callback may fill the queue or it may have been
+            // filled in the meantime
+            val = popLocked();
+            if (val) {
+                break;
             }
-            checkPullAndSwap();
-            if (!pullElements.empty()) {
-                // the callback may fill the queue or it may have been
-                // filled in the meantime
-                auto actval = std::move(pullElements.back());
-                pullElements.pop_back();
-                return actval;
+            parkConsumer(pullLock, val, Lane::any);
+            if (val) {
+                break;
             }
-            condition.wait(pullLock);
             // need to check again to handle spurious wake-up
-            if (!priorityQueue.empty()) {
-                auto actval = std::move(priorityQueue.front());
-                priorityQueue.pop();
-                return actval;
+            val = try_pop();
+        }
+        return std::move(*val);
+    }
+
+    /** try to pop an object from the priority channel only
+@return an optional containing the value if successful the optional will be
+empty if there is no element in the priority channel
+*/
+    std::optional<T> try_pop_priority() { return tryPopPriorityChannel(); }
+
+    /** blocking call to wait on an object from the priority channel
+@details elements on the normal lane are never consumed by this call*/
+    T pop_priority()
+    {
+        auto val = tryPopPriorityChannel();
+        while (!val) {
+            // the priority lane does not need the pull lock to wait
+            std::unique_lock<MUTEX> pullLock(m_pullLock, std::defer_lock);
+            parkConsumer(pullLock, val, Lane::priority);
+            if (!val) {
+                val = tryPopPriorityChannel();
             }
+        }
+        return std::move(*val);
+    }
+
+    /** blocking call to wait on an object from the priority channel with
+timeout*/
+    template<typename TIME>
+    std::optional<T> pop_priority(TIME timeout)
+    {
+        auto val = tryPopPriorityChannel();
+        while (!val) {
+            std::unique_lock<MUTEX> pullLock(m_pullLock, std::defer_lock);
+            const bool noTimeout =
+                parkConsumer(pullLock, val, Lane::priority, &timeout);
+            if (!val) {
+                val = tryPopPriorityChannel();
+            }
+            if (!noTimeout) {
+                break;
+            }
+        }
+        return val;
+    }
+
+    /** try to pop an object from the normal lane only
+@return an optional containing the value if successful the optional will be
+empty if there is no element on the normal lane
+*/
+    std::optional<T> try_pop_normal()
+    {
+        std::lock_guard<MUTEX> pullLock(m_pullLock);  // first pullLock
+        auto val = popNormalLocked();
+        if (val) {
             checkPullAndSwap();
-            if (!pullElements.empty()) {
-                auto actval = std::move(pullElements.back());
-                pullElements.pop_back();
-                return actval;
+        }
+        return val;
+    }
+
+    /** blocking call to wait on an object from the normal lane
+@details elements on the priority channel are never consumed by this call*/
+    T pop_normal()
+    {
+        auto val = try_pop_normal();
+        while (!val) {
+            std::unique_lock<MUTEX> pullLock(m_pullLock);
+            val = popNormalLocked();
+            if (val) {
+                break;
             }
-            pullLock.unlock();
-            val = try_pop();
+            parkConsumer(pullLock, val, Lane::normal);
+            val = try_pop_normal();
         }
         return std::move(*val);
     }
 
+    /** blocking call to wait on an object from the normal lane with
+timeout*/
+    template<typename TIME>
+    std::optional<T> pop_normal(TIME timeout)
+    {
+        auto val = try_pop_normal();
+        while (!val) {
+            std::unique_lock<MUTEX> pullLock(m_pullLock);
+            val = popNormalLocked();
+            if (val) {
+                break;
+            }
+            const bool noTimeout =
+                parkConsumer(pullLock, val, Lane::normal, &timeout);
+            val = try_pop_normal();
+            if (!noTimeout) {
+                break;
+            }
+        }
+        return val;
+    }
+
+    /** remove all elements matching a predicate from the queue
+@details the priority channel and both internal vectors are compacted in a
+single pass with all locks held, so no element is popped and discarded
+individually
+@param pred a unary predicate returning true for elements to remove
+@return the number of elements removed
+*/
+    template<class Pred>
+    size_t remove_if(Pred pred)
+    {
+        std::lock_guard<MUTEX> pullLock(m_pullLock);  // first pullLock
+        std::lock_guard<MUTEX> pushLock(m_pushLock);  // second pushLock
+        std::lock_guard<MUTEX> priorityLock(m_priorityLock);
+        const size_t removed = std::erase_if(priorityQueue, pred) +
+            std::erase_if(pullElements, pred) +
+            std::erase_if(pushElements, pred);
+        priorityCount = priorityQueue.size();
+        if (pullElements.empty() && pushElements.empty()) {
+            queueEmptyFlag = true;
+        }
+        return removed;
+    }
+
     /** check whether there are any elements in the queue
 because this is meant for multi-threaded applications this may or may not have
 any meaning depending on the number of consumers
-@note this is an advisory lock-free snapshot based on queueEmptyFlag; it is
+@note this is an advisory lock-free snapshot based on queueEmptyFlag and the
+priority channel count; it is
 not a synchronized guarantee that pushElements, pullElements, and
 priorityQueue are all empty at the instant it is observed.
 */
@@ -423,32 +530,203 @@ lock order is always pull -> push.
             }
         }
     }
+
+    /** check if the fairness ratio requires the next pop to come from the
+normal lane*/
+    bool normalLaneDue() const
+    {
+        const int ratio = priorityRatio.load();
+        return (ratio > 0) && (priorityStreak.load() >= ratio);
+    }
+
+    /** extract an element from the priority channel
+@details only m_priorityLock is taken so this may be called with or without
+m_pullLock held*/
+    std::optional<T> tryPopPriorityChannel()
+    {
+        if (priorityCount.load() == 0) {
+            return std::nullopt;
+        }
+        std::lock_guard<MUTEX> priorityLock(m_priorityLock);
+        if (priorityQueue.empty()) {
+            return std::nullopt;
+        }
+        std::optional<T> val(std::move(priorityQueue.front()));
+        priorityQueue.pop_front();
+        --priorityCount;
+        return val;
+    }
+
+    /** extract an element from the priority channel as part of the fairness
+decision
+@details the lane-selective pops bypass the fairness ratio so only the pops
+through this call count toward the priority streak*/
+    std::optional<T> tryPopPriorityFair()
+    {
+        auto val = tryPopPriorityChannel();
+        if (val && priorityRatio.load() > 0) {
+            ++priorityStreak;
+        }
+        return val;
+    }
+
+    /** extract the next element from either channel
+@details must be called with m_pullLock held; the priority channel is served
+first unless the fairness ratio says the normal lane is due*/
+    std::optional<T> popLocked()
+    {
+        std::optional<T> val;
+        const bool normalDue = normalLaneDue();
+        if (!normalDue) {
+            val = tryPopPriorityFair();
+            if (val) {
+                return val;
+            }
+        }
+        val = popNormalLocked();
+        if (!val) {
+            if (normalDue) {
+                val = tryPopPriorityFair();
+            }
+            return val;
+        }
+        if (normalDue && priorityCount.load() > 0) {
+            ++fairnessCount;
+        }
+        priorityStreak = 0;
+        return val;
+    }
+
+    /** extract an element from the normal lane
+@details must be called with m_pullLock held*/
+    std::optional<T> popNormalLocked()
+    {
+        std::optional<T> val;
+        checkPullAndSwap();
+        if (!pullElements.empty()) {
+            // do it this way to allow movable only types
+            val.emplace(std::move(pullElements.back()));
+            pullElements.pop_back();
+        }
+        return val;
+    }
+
+    /** park the calling consumer until the queue state changes
+@details pullLock is released once the consumer is registered, it is not
+required to be held when waiting on the priority lane only.  The consumer
+registers a slot under m_priorityLock so producers can either wake it or hand
+a priority element directly to it.
+@param pullLock the lock on m_pullLock, held unless lane is Lane::priority
+@param val set to the element handed to this consumer if there was one
+@param lane the channels the consumer is waiting on
+@param timeout pointer to the maximum wait time, nullptr to wait indefinitely
+@return false if the wait timed out
+*/
+    template<typename TIME = std::chrono::milliseconds>
+    bool parkConsumer(
+        std::unique_lock<MUTEX>& pullLock,
+        std::optional<T>& val,
+        Lane lane,
+        const TIME* timeout = nullptr)
+    {
+        WaitSlot slot;
+        slot.lane = lane;
+        std::unique_lock<MUTEX> priorityLock(m_priorityLock);
+        waiters.push_back(&slot);
+        if (pullLock.owns_lock()) {
+            pullLock.unlock();
+        }
+        // a producer that cleared the empty flag before the slot was
+        // registered will not see it, so check the flag as well
+        auto ready = [this, &slot]() {
+            if (slot.signaled) {
+                return true;
+            }
+            switch (slot.lane) {
+                case Lane::priority:
+                    return priorityCount.load() > 0;
+                case Lane::normal:
+                    return !queueEmptyFlag.load();
+                case Lane::any:
+                default:
+                    return !queueEmptyFlag.load() || priorityCount.load() > 0;
+            }
+        };
+        bool noTimeout{true};
+        if (timeout == nullptr) {
+            slot.condition.wait(priorityLock, ready);
+        } else {
+            noTimeout = slot.condition.wait_for(priorityLock, *timeout, ready);
+        }
+        if (!slot.signaled) {
+            waiters.erase(std::find(waiters.begin(), waiters.end(), &slot));
+        }
+        if (slot.value) {
+            val = std::move(slot.value);
+        }
+        return noTimeout;
+    }
+
+    /** remove the longest waiting consumer that accepts priority elements
+and wake it
+@details must be called with m_priorityLock held
+@return a pointer to the slot for the producer to fill, nullptr if no parked
+consumer accepts priority elements*/
+    WaitSlot* handoff()
+    {
+        auto slotIt =
+            std::find_if(waiters.begin(), waiters.end(), [](WaitSlot* slot) {
+                return slot->lane != Lane::normal;
+            });
+        if (slotIt == waiters.end()) {
+            return nullptr;
+        }
+        WaitSlot* slot = *slotIt;
+        waiters.erase(slotIt);
+        slot->signaled = true;
+        // notify while the lock is held since the slot lives on the stack of
+        // the consumer and may be gone once the lock is released
+        slot->condition.notify_one();
+        return slot;
+    }
+
+    /** wake all parked consumers waiting on the normal lane so they re-check
+the queue*/
+    void wakeConsumers()
+    {
+        std::lock_guard<MUTEX> priorityLock(m_priorityLock);
+        std::erase_if(waiters, [](WaitSlot* slot) {
+            if (slot->lane == Lane::priority) {
+                return false;
+            }
+            slot->signaled = true;
+            slot->condition.notify_one();
+            return true;
+        });
+    }
 };
 
 template<typename T, class MUTEX, class COND>
 std::optional<T> BlockingPriorityQueue<T, MUTEX, COND>::try_pop()
 {
-    std::lock_guard<MUTEX> pullLock(m_pullLock);  // first pullLock
-    if (!priorityQueue.empty()) {
-        std::optional<T> val(std::move(priorityQueue.front()));
-        priorityQueue.pop();
-        return val;
+    if (!normalLaneDue()) {
+        auto val = tryPopPriorityFair();
+        if (val) {
+            return val;
+        }
     }
-    checkPullAndSwap();
-    if (pullElements.empty()) {
-        return std::nullopt;
+    std::lock_guard<MUTEX> pullLock(m_pullLock);  // first pullLock
+    auto val = popLocked();
+    if (val) {
+        checkPullAndSwap();
     }
-    // do it this way to allow movable only types
-    std::optional<T> val(std::move(pullElements.back()));
-    pullElements.pop_back();
-    checkPullAndSwap();
     return val;
 }
 
 template<typename T, class MUTEX, class COND>
 bool BlockingPriorityQueue<T, MUTEX, COND>::empty() const
 {
-    return queueEmptyFlag.load();
+    return queueEmptyFlag.load() && (priorityCount.load() == 0);
 }
 
 }  // namespace gmlc::containers
@@ -317,6 +317,25 @@ empty will block and wait.
         return std::move(*val);
     }
 
+    /** remove all elements matching a predicate from the queue
+@details both internal vectors are compacted in a single pass with both locks
+held, so no element is popped and discarded individually
+@param pred a unary predicate returning true for elements to remove
+@return the number of elements removed
+*/
+    template<class Pred>
+    size_t remove_if(Pred pred)
+    {
+        std::lock_guard<MUTEX> pullLock(m_pullLock);  // first pullLock
+        std::lock_guard<MUTEX> pushLock(m_pushLock);  // second pushLock
+        const size_t removed = std::erase_if(pullElements, pred) +
+            std::erase_if(pushElements, pred);
+        if (pullElements.empty() && pushElements.empty()) {
+            queueEmptyFlag = true;
+        }
+        return removed;
+    }
+
     /** check whether there are any elements in the queue
 because this is meant for multi-threaded applications this may or may not have
 any meaning depending on the number of consumers
@@ -0,0 +1,222 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved.
+
+SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include "WorkQueue.hpp"
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace gmlc::containers {
+template<typename T>
+class CoroutineTask;
+
+namespace detail {
+    /** blocks a thread until a coroutine task has completed*/
+    class CoroutineWaiter {
+      public:
+        /** mark the task as completed and wake the waiting thread*/
+        void notify()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready = true;
+            condition.notify_all();
+        }
+        /** wait until notify has been called*/
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return ready; });
+        }
+
+      private:
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool ready{false};
+    };
+
+    /** the parts of the CoroutineTask promise that do not depend on the
+    result type*/
+    class CoroutinePromiseBase {
+      public:
+        /** hands control to whoever waits for the task once it completes*/
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            template<typename Promise>
+            std::coroutine_handle<>
+                await_suspend(std::coroutine_handle<Promise> handle) noexcept
+            {
+                auto& promise = handle.promise();
+                if (promise.continuation) {
+                    return promise.continuation;
+                }
+                if (promise.waiter != nullptr) {
+                    promise.waiter->notify();
+                }
+                return std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void unhandled_exception() noexcept
+        {
+            error = std::current_exception();
+        }
+
+        std::coroutine_handle<> continuation;  //!< coroutine awaiting the task
+        CoroutineWaiter* waiter{nullptr};  //!< thread blocked in get()
+        std::exception_ptr error;  //!< the exception thrown by the task
+    };
+
+    template<typename T>
+    class CoroutinePromise : public CoroutinePromiseBase {
+      public:
+        CoroutineTask<T> get_return_object() noexcept;
+        template<typename U>
+        void return_value(U&& result)
+        {
+            value.emplace(std::forward<U>(result));
+        }
+        /** get the result or rethrow the exception of the task*/
+        T result()
+        {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return std::move(*value);
+        }
+
+      private:
+        std::optional<T> value;  //!< the result of the task
+    };
+
+    template<>
+    class CoroutinePromise<void> : public CoroutinePromiseBase {
+      public:
+        CoroutineTask<void> get_return_object() noexcept;
+        void return_void() const noexcept {}
+        /** rethrow the exception of the task if there is one*/
+        void result() const
+        {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    };
+}  // namespace detail
+
+/** coroutine producing a value of type T
+@details the coroutine does not start until it is awaited or get() is
+called.  Awaiting it from another coroutine transfers control to it directly,
+and once it completes the awaiting coroutine continues on the thread that
+completed it, so a task that has moved onto a WorkQueue with
+co_await queue.schedule() resumes the awaiting coroutine on the workers
+without blocking any of them.  Exceptions thrown by the coroutine are
+rethrown to the awaiting coroutine or by get().
+*/
+template<typename T = void>
+class CoroutineTask {
+  public:
+    using promise_type = detail::CoroutinePromise<T>;
+
+    CoroutineTask() noexcept = default;
+    explicit CoroutineTask(
+        std::coroutine_handle<promise_type> coroutine) noexcept :
+        handle(coroutine)
+    {
+    }
+    CoroutineTask(CoroutineTask&& task) noexcept :
+        handle(std::exchange(task.handle, nullptr))
+    {
+    }
+    CoroutineTask& operator=(CoroutineTask&& task) noexcept
+    {
+        if (this != &task) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(task.handle, nullptr);
+        }
+        return *this;
+    }
+    CoroutineTask(const CoroutineTask&) = delete;
+    CoroutineTask& operator=(const CoroutineTask&) = delete;
+    ~CoroutineTask()
+    {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    /** check if the object holds a coroutine*/
+    bool valid() const noexcept { return static_cast<bool>(handle); }
+    /** check if the coroutine has completed*/
+    bool isDone() const noexcept { return handle && handle.done(); }
+
+    /** awaiter starting the task and resuming the awaiting coroutine with
+    its result*/
+    struct Awaiter {
+        std::coroutine_handle<promise_type> coroutine;
+        bool await_ready() const noexcept { return coroutine.done(); }
+        std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            coroutine.promise().continuation = awaiting;
+            return coroutine;
+        }
+        T await_resume() { return coroutine.promise().result(); }
+    };
+    Awaiter operator co_await() & noexcept { return Awaiter{handle}; }
+    Awaiter operator co_await() && noexcept { return Awaiter{handle}; }
+
+    /** run the task and block the calling thread until it completes
+@details this is meant for threads outside the queue, blocking a worker this
+way can deadlock a queue with few workers.  The task must not have been
+awaited already.
+@return the result of the task
+*/
+    T get()
+    {
+        if (!handle.done()) {
+            detail::CoroutineWaiter waiter;
+            handle.promise().waiter = &waiter;
+            handle.resume();
+            waiter.wait();
+        }
+        return handle.promise().result();
+    }
+
+  private:
+    std::coroutine_handle<promise_type> handle;  //!< the coroutine
+};
+
+namespace detail {
+    template<typename T>
+    CoroutineTask<T> CoroutinePromise<T>::get_return_object() noexcept
+    {
+        return CoroutineTask<T>(
+            std::coroutine_handle<CoroutinePromise<T>>::from_promise(*this));
+    }
+    inline CoroutineTask<void>
+        CoroutinePromise<void>::get_return_object() noexcept
+    {
+        return CoroutineTask<void>(
+            std::coroutine_handle<CoroutinePromise<void>>::from_promise(
+                *this));
+    }
+}  // namespace detail
+
+}  // namespace gmlc::containers
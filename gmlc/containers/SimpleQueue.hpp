@@ -13,6 +13,7 @@ SPDX-License-Identifier: BSD-3-Clause
 
 #include <algorithm>
 #include <atomic>
+#include <iterator>
 #include <mutex>
 #include <type_traits>
 #include <utility>
@@ -145,6 +146,9 @@ val the value to push on the queue
     */
     void pushVector(const std::vector<X>& val)  // universal reference
     {
+        if (val.empty()) {
+            return;
+        }
         std::unique_lock<MUTEX> pushLock(
             m_pushLock);  // only one lock on this branch
         if (pushElements.empty()) {
@@ -165,6 +169,32 @@ val the value to push on the queue
         pushElements.insert(pushElements.end(), val.begin(), val.end());
     }
 
+    /** move a vector of elements onto the queue
+    val the vector of values to move onto the queue, it is left empty
+    if the push side of the queue is empty the buffer of val is taken over
+    instead of moving the elements one by one, and like other pushed elements
+    they are reversed when the pull side swaps them in
+    */
+    void pushVector(std::vector<X>&& val)
+    {
+        if (val.empty()) {
+            return;
+        }
+        std::lock_guard<MUTEX> pushLock(
+            m_pushLock);  // only one lock on this branch
+        if (pushElements.empty()) {
+            pushElements.swap(val);
+        } else {
+            pushElements.insert(
+                pushElements.end(),
+                std::make_move_iterator(val.begin()),
+                std::make_move_iterator(val.end()));
+        }
+        val.clear();
+        // the flag is only set by a pull while it holds the push lock
+        queueEmptyFlag.store(false);
+    }
+
     /** emplace an element onto the queue
 val the value to emplace on the queue
 */
@@ -226,7 +256,12 @@ contain a value
         std::lock_guard<MUTEX> lock(m_pullLock);
 
         if (pullElements.empty()) {
-            return std::nullopt;
+            // a moved vector may wait on the push side until the next pop
+            std::lock_guard<MUTEX> pushLock(m_pushLock);  // second pushLock
+            if (pushElements.empty()) {
+                return std::nullopt;
+            }
+            return pushElements.front();
         }
 
         auto t = pullElements.back();
@@ -0,0 +1,209 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved.
+
+SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include "WorkQueue.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gmlc::containers {
+/** serial executors (strands) keyed by an id running on a WorkQueue
+@details work posted with the same key runs one task at a time in the order it
+was posted, so the tasks of a key need no locks of their own, while work with
+different keys runs concurrently on the workers.  A key only has state while
+it has work queued or running: the first post to an idle key queues a runner
+on the WorkQueue that executes the pending tasks of the key in batches and
+removes the key once nothing is left.  The keys are spread over a fixed set of
+shards, each with a small lock held only to append or take the pending tasks.
+An exception thrown by a callable is dropped and counted by getTaskErrorCount
+of the WorkQueue, the following tasks of the strand still run; post a work
+block to get the exception through its future.  If the WorkQueue is closed the
+pending work of a strand is dropped along with its runner.  The executor can
+be destroyed while work is pending, the WorkQueue must outlive the work.
+@tparam Key the type of the strand id
+@tparam Hash the hash function for the key
+*/
+template<typename Key, typename Hash = std::hash<Key>>
+class StrandExecutor {
+  public:
+    /** construct the executor
+@param[in] queue the WorkQueue to execute the work on
+@param[in] priority the priority the strands are queued with*/
+    explicit StrandExecutor(
+        WorkQueue& queue,
+        WorkQueue::WorkPriority priority = WorkQueue::WorkPriority::medium) :
+        state(std::make_shared<State>(queue, priority))
+    {
+    }
+
+    /** add work to the strand of a key
+@param[in] key the id of the strand
+@param[in] work a work block or a nullary callable*/
+    template<typename Work>
+    void post(const Key& key, Work&& work)
+    {
+        if constexpr (std::is_convertible_v<
+                          Work,
+                          std::shared_ptr<BasicWorkBlock>>) {
+            std::shared_ptr<BasicWorkBlock> block(std::forward<Work>(work));
+            if (!block || block->isFinished()) {
+                return;
+            }
+            State::post(
+                state, key, WorkTask([block = std::move(block)]() {
+                    block->execute();
+                }));
+        } else {
+            State::post(state, key, WorkTask(std::forward<Work>(work)));
+        }
+    }
+
+    /** get the number of strands with work queued or running*/
+    std::size_t activeStrands() const { return state->active.load(); }
+    /** check if no strand has work queued or running*/
+    bool isIdle() const { return state->active.load() == 0; }
+
+  private:
+    static constexpr std::size_t shardCount{16};
+
+    /** a set of strands sharing a lock*/
+    struct alignas(64) Shard {
+        std::mutex lock;  //!< lock protecting the pending work
+        /** the pending work of the active strands*/
+        std::unordered_map<Key, std::vector<WorkTask>, Hash> strands;
+    };
+    /** state shared with the queued runners*/
+    struct State {
+        State(WorkQueue& workQueue, WorkQueue::WorkPriority workPriority) :
+            queue(workQueue), priority(workPriority)
+        {
+        }
+        Shard& shardOf(const Key& key)
+        {
+            return shards[Hash{}(key) % shardCount];
+        }
+        /** append work to a strand and queue a runner if it was idle*/
+        static void post(
+            const std::shared_ptr<State>& state,
+            const Key& key,
+            WorkTask&& task)
+        {
+            auto& shard = state->shardOf(key);
+            bool idle{false};
+            {
+                std::lock_guard<std::mutex> guard(shard.lock);
+                auto [strand, inserted] = shard.strands.try_emplace(key);
+                strand->second.push_back(std::move(task));
+                if (inserted) {
+                    ++state->active;
+                    idle = true;
+                }
+            }
+            if (idle) {
+                schedule(state, key);
+            }
+        }
+        /** queue a runner for a strand*/
+        static void
+            schedule(const std::shared_ptr<State>& state, const Key& key)
+        {
+            state->queue.addTask(Runner(state, key), state->priority);
+        }
+        /** drop the pending work of a strand whose runner was dropped or
+        rejected by a closed queue*/
+        static void
+            abandon(const std::shared_ptr<State>& state, const Key& key)
+        {
+            auto& shard = state->shardOf(key);
+            std::vector<WorkTask> dropped;
+            {
+                std::lock_guard<std::mutex> guard(shard.lock);
+                auto strand = shard.strands.find(key);
+                dropped.swap(strand->second);
+                shard.strands.erase(strand);
+                --state->active;
+            }
+        }
+        /** execute the pending work of a strand
+@details the work posted while the batch runs is executed by a new runner so
+a busy strand does not hold a worker indefinitely*/
+        static void run(const std::shared_ptr<State>& state, const Key& key)
+        {
+            auto& shard = state->shardOf(key);
+            std::vector<WorkTask> batch;
+            {
+                std::lock_guard<std::mutex> guard(shard.lock);
+                batch.swap(shard.strands.find(key)->second);
+            }
+            for (auto& task : batch) {
+                state->queue.runTask(task);
+            }
+            {
+                std::lock_guard<std::mutex> guard(shard.lock);
+                auto strand = shard.strands.find(key);
+                if (strand->second.empty()) {
+                    shard.strands.erase(strand);
+                    --state->active;
+                    return;
+                }
+            }
+            schedule(state, key);
+        }
+
+        /** the queued task running a strand
+@details a runner destroyed without running, as when a closed queue rejects it
+or clears it from its lanes, releases the strand*/
+        class Runner {
+          public:
+            Runner(std::shared_ptr<State> strandState, const Key& strandKey) :
+                state(std::move(strandState)), key(strandKey)
+            {
+            }
+            Runner(Runner&& other) noexcept(
+                std::is_nothrow_move_constructible_v<Key>) = default;
+            Runner& operator=(Runner&& other) = delete;
+            Runner(const Runner&) = delete;
+            Runner& operator=(const Runner&) = delete;
+            ~Runner()
+            {
+                if (state) {
+                    abandon(state, key);
+                }
+            }
+            void operator()()
+            {
+                const auto owner = std::move(state);
+                run(owner, key);
+            }
+
+          private:
+            std::shared_ptr<State> state;  //!< empty once run or moved from
+            Key key;  //!< the key of the strand
+        };
+
+        std::array<Shard, shardCount> shards;  //!< the strands by key hash
+        std::atomic<std::size_t> active{0};  //!< the number of active strands
+        WorkQueue& queue;  //!< the queue executing the work
+        WorkQueue::WorkPriority priority;  //!< the priority of the runners
+    };
+
+    std::shared_ptr<State> state;  //!< the strands shared with the runners
+};
+
+}  // namespace gmlc::containers
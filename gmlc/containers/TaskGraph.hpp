@@ -0,0 +1,207 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved.
+
+SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include "WorkQueue.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace gmlc::containers {
+/** a set of tasks with dependencies between them executed on a WorkQueue
+@details tasks are added with addTask and ordered with addDependency, once
+submitted every task whose predecessors have completed is added to the queue
+by the thread that completed the last predecessor.  The remaining dependency
+count of each task is an atomic counter so no worker ever waits on another
+task.
+*/
+class TaskGraph {
+  public:
+    /** identifier of a task in the graph*/
+    using TaskId = std::size_t;
+
+    TaskGraph() = default;
+    /** add a task to the graph
+@param[in] task a nullary callable to execute
+@param[in] priority the priority used when the task is added to the queue
+@return the identifier of the task*/
+    template<typename Func>
+    TaskId addTask(
+        Func&& task,
+        WorkQueue::WorkPriority priority = WorkQueue::WorkPriority::medium)
+    {
+        nodes.emplace_back();
+        nodes.back().work = WorkTask(std::forward<Func>(task));
+        nodes.back().priority = priority;
+        return nodes.size() - 1;
+    }
+    /** declare that a task can only start after another one has completed
+@param[in] before the task that must complete first
+@param[in] after the task that depends on it
+@throw std::out_of_range if either task is not part of the graph
+*/
+    void addDependency(TaskId before, TaskId after)
+    {
+        if (before >= nodes.size() || after >= nodes.size()) {
+            throw(std::out_of_range("task is not part of the graph"));
+        }
+        nodes[before].successors.push_back(after);
+        ++nodes[after].dependencies;
+    }
+    /** get the number of tasks in the graph*/
+    std::size_t size() const { return nodes.size(); }
+    /** check if the graph has no tasks*/
+    bool empty() const { return nodes.empty(); }
+
+    /** submit the graph for execution
+@details the tasks are moved out of the graph which is left empty.  If a task
+throws, tasks that have not started are skipped and the exception is
+forwarded to the returned future.  If the queue is closed before all tasks
+have run, the tasks it drops are never run and the future reports
+WorkCancelled once the tasks already running have finished.
+@param[in] queue the WorkQueue to execute the tasks on
+@return a future that becomes ready once all tasks have completed
+@throw std::invalid_argument if the dependencies contain a cycle
+*/
+    std::shared_future<void> submit(WorkQueue& queue)
+    {
+        checkAcyclic();
+        auto state = std::make_shared<RunState>(std::move(nodes), queue);
+        nodes.clear();
+        std::shared_future<void> result = state->done.get_future();
+        if (state->nodes.empty()) {
+            state->done.set_value();
+            return result;
+        }
+        std::vector<TaskId> ready;
+        for (TaskId id = 0; id < state->nodes.size(); ++id) {
+            if (state->nodes[id].dependencies == 0) {
+                ready.push_back(id);
+            }
+        }
+        for (auto id : ready) {
+            RunState::schedule(state, id);
+        }
+        return result;
+    }
+
+  private:
+    /** a task and its outgoing edges*/
+    struct Node {
+        WorkTask work;  //!< the work to execute
+        WorkQueue::WorkPriority priority{
+            WorkQueue::WorkPriority::medium};  //!< the priority of the work
+        std::vector<TaskId> successors;  //!< tasks depending on this one
+        int dependencies{0};  //!< number of predecessors
+    };
+    /** shared state of a submitted graph*/
+    struct RunState {
+        RunState(std::vector<Node>&& graphNodes, WorkQueue& workQueue) :
+            nodes(std::move(graphNodes)),
+            pending(std::make_unique<std::atomic<int>[]>(nodes.size())),
+            remaining(nodes.size()), queue(workQueue)
+        {
+            for (std::size_t ii = 0; ii < nodes.size(); ++ii) {
+                pending[ii].store(nodes[ii].dependencies);
+            }
+        }
+        RunState(const RunState&) = delete;
+        RunState& operator=(const RunState&) = delete;
+        /** the state is released once no queued task refers to it, tasks
+        dropped or rejected by a closed queue never complete*/
+        ~RunState()
+        {
+            if (remaining.load() != 0) {
+                done.set_exception(
+                    error ? error : std::make_exception_ptr(WorkCancelled()));
+            }
+        }
+        /** add a ready task to the queue*/
+        static void schedule(const std::shared_ptr<RunState>& state, TaskId id)
+        {
+            state->queue.addTask(
+                [state, id]() { run(state, id); }, state->nodes[id].priority);
+        }
+        /** execute a task and release its successors*/
+        static void run(const std::shared_ptr<RunState>& state, TaskId id)
+        {
+            auto& node = state->nodes[id];
+            if (!state->failed.load()) {
+                try {
+                    node.work();
+                }
+                catch (...) {
+                    if (!state->failed.exchange(true)) {
+                        state->error = std::current_exception();
+                    }
+                }
+            }
+            node.work.reset();
+            for (auto next : node.successors) {
+                if (--state->pending[next] == 0) {
+                    schedule(state, next);
+                }
+            }
+            if (--state->remaining == 0) {
+                if (state->error) {
+                    state->done.set_exception(state->error);
+                } else {
+                    state->done.set_value();
+                }
+            }
+        }
+
+        std::vector<Node> nodes;  //!< the tasks of the graph
+        /** remaining predecessor count of each task*/
+        std::unique_ptr<std::atomic<int>[]> pending;
+        std::atomic<std::size_t> remaining;  //!< tasks not yet completed
+        std::atomic<bool> failed{false};  //!< set once a task has thrown
+        std::exception_ptr error;  //!< the first exception thrown
+        std::promise<void> done;  //!< set once all tasks have completed
+        WorkQueue& queue;  //!< the queue executing the tasks
+    };
+
+    /** check the dependencies with a topological sort*/
+    void checkAcyclic() const
+    {
+        std::vector<int> counts(nodes.size());
+        std::vector<TaskId> ready;
+        for (TaskId id = 0; id < nodes.size(); ++id) {
+            counts[id] = nodes[id].dependencies;
+            if (counts[id] == 0) {
+                ready.push_back(id);
+            }
+        }
+        std::size_t visited{0};
+        while (!ready.empty()) {
+            auto id = ready.back();
+            ready.pop_back();
+            ++visited;
+            for (auto next : nodes[id].successors) {
+                if (--counts[next] == 0) {
+                    ready.push_back(next);
+                }
+            }
+        }
+        if (visited != nodes.size()) {
+            throw(std::invalid_argument("task graph contains a cycle"));
+        }
+    }
+
+    std::vector<Node> nodes;  //!< the tasks in the graph
+};
+
+}  // namespace gmlc::containers
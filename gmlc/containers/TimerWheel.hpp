@@ -0,0 +1,371 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved.
+
+SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace gmlc::containers {
+/** handle identifying a timer in a TimerWheel*/
+struct TimerHandle {
+    std::uint32_t index{std::numeric_limits<std::uint32_t>::max()};
+    std::uint32_t generation{0};
+    /** check if the handle refers to a timer at all*/
+    bool valid() const
+    {
+        return index != std::numeric_limits<std::uint32_t>::max();
+    }
+};
+
+/** hierarchical timing wheel holding values that expire at a given time
+@details time is divided into ticks of a fixed resolution.  The wheel has
+levels of 64 slots, level 0 covers the next 64 ticks one tick per slot and
+each higher level covers 64 times the span of the one below it.  Inserting
+and cancelling a timer are O(1), and entries in a higher level move down when
+the wheel reaches the start of their slot.  Timers further out than the span
+of the top level are parked in its farthest slot until they come into range.
+Timers never fire early, they fire on the first tick at or after their expiry.
+The class is not thread safe.
+@tparam T the type of value stored with each timer, must be default
+constructible and movable
+*/
+template<typename T>
+class TimerWheel {
+  public:
+    using clock = std::chrono::steady_clock;
+    /** the number of levels in the wheel*/
+    static constexpr int levels{5};
+
+    /** construct a wheel
+@param[in] tickResolution the duration of one tick
+@param[in] start the time of tick 0*/
+    explicit TimerWheel(
+        clock::duration tickResolution = std::chrono::milliseconds(1),
+        clock::time_point start = clock::now()) :
+        resolution(
+            tickResolution > clock::duration::zero() ? tickResolution :
+                                                       clock::duration(1)),
+        startTime(start)
+    {
+        for (auto& level : slots) {
+            level.fill(npos);
+        }
+    }
+
+    /** add a timer
+@param[in] expiry the time the timer fires
+@param[in] value the value to store with the timer
+@param[in] period if greater than zero the timer fires repeatedly with this
+period until it is cancelled
+@return a handle that can be used to cancel the timer*/
+    TimerHandle insert(
+        clock::time_point expiry,
+        T value,
+        clock::duration period = clock::duration::zero())
+    {
+        const auto index = allocateNode();
+        auto& node = nodes[index];
+        node.value = std::move(value);
+        node.expiry = std::max(toTick(expiry), currentTick + 1);
+        node.period = (period > clock::duration::zero()) ?
+            std::max<std::uint64_t>(
+                static_cast<std::uint64_t>(
+                    (period + resolution - clock::duration(1)) / resolution),
+                1) :
+            0;
+        place(index);
+        ++count;
+        return {index, node.generation};
+    }
+
+    /** cancel a timer
+@return true if the timer was pending and has been removed, false if it had
+already fired or the handle is not valid*/
+    bool cancel(const TimerHandle& handle)
+    {
+        if (!isPending(handle)) {
+            return false;
+        }
+        unlink(handle.index);
+        releaseNode(handle.index);
+        --count;
+        return true;
+    }
+
+    /** check if a timer is still pending*/
+    bool isPending(const TimerHandle& handle) const
+    {
+        return handle.index < nodes.size() &&
+            nodes[handle.index].generation == handle.generation &&
+            nodes[handle.index].level >= 0;
+    }
+
+    /** move the wheel forward to a point in time
+@param[in] now the current time
+@param[in] onExpired called with a reference to the value of every timer
+that expires, in order of expiry.  The value of a single shot timer is
+destroyed after the call, periodic timers are rescheduled for their first
+period after now so missed periods are skipped rather than fired in a burst.
+The callback must not modify the wheel.
+*/
+    template<typename Callback>
+    void advance(clock::time_point now, Callback&& onExpired)
+    {
+        const auto target = toTickFloor(now);
+        while (currentTick < target) {
+            const auto next = nextEventTick();
+            if (!next || *next > target) {
+                currentTick = target;
+                break;
+            }
+            currentTick = *next;
+            processTick(onExpired, target);
+        }
+    }
+
+    /** get the time of the next event of the wheel
+@details this is the expiry of the next timer in level 0 or the time a
+higher level slot moves down, so it may be earlier than the next expiry but
+never later
+@return the time or an empty optional if no timer is pending*/
+    std::optional<clock::time_point> nextEventTime() const
+    {
+        auto next = nextEventTick();
+        if (!next) {
+            return std::nullopt;
+        }
+        return startTime +
+            resolution * static_cast<clock::duration::rep>(*next);
+    }
+
+    /** get the number of pending timers*/
+    std::size_t size() const { return count; }
+    /** check if there are no pending timers*/
+    bool empty() const { return count == 0; }
+    /** get the duration of a tick*/
+    clock::duration getResolution() const { return resolution; }
+    /** remove all timers*/
+    void clear()
+    {
+        for (std::uint32_t ii = 0; ii < nodes.size(); ++ii) {
+            if (nodes[ii].level >= 0) {
+                releaseNode(ii);
+            }
+        }
+        for (auto& level : slots) {
+            level.fill(npos);
+        }
+        occupancy.fill(0);
+        count = 0;
+    }
+
+  private:
+    static constexpr std::uint32_t npos{
+        std::numeric_limits<std::uint32_t>::max()};
+    static constexpr int slotBits{6};
+    static constexpr std::uint64_t slotMask{63};
+
+    struct Node {
+        T value{};
+        std::uint64_t expiry{0};  //!< tick at which the timer fires
+        std::uint64_t period{0};  //!< period in ticks or 0 for single shot
+        std::uint32_t prev{npos};
+        std::uint32_t next{npos};  //!< also links the free list
+        std::uint32_t generation{0};
+        int level{-1};  //!< the level holding the node or -1 if free
+        int slot{0};
+    };
+
+    std::uint64_t toTickFloor(clock::time_point time) const
+    {
+        if (time <= startTime) {
+            return 0;
+        }
+        return static_cast<std::uint64_t>((time - startTime) / resolution);
+    }
+    std::uint64_t toTick(clock::time_point time) const
+    {
+        if (time <= startTime) {
+            return 0;
+        }
+        const auto elapsed = time - startTime;
+        auto ticks = static_cast<std::uint64_t>(elapsed / resolution);
+        if (resolution * static_cast<clock::duration::rep>(ticks) < elapsed) {
+            ++ticks;
+        }
+        return ticks;
+    }
+
+    std::uint32_t allocateNode()
+    {
+        if (freeHead != npos) {
+            const auto index = freeHead;
+            freeHead = nodes[index].next;
+            return index;
+        }
+        nodes.emplace_back();
+        return static_cast<std::uint32_t>(nodes.size() - 1);
+    }
+    void releaseNode(std::uint32_t index)
+    {
+        auto& node = nodes[index];
+        node.value = T{};
+        node.level = -1;
+        ++node.generation;
+        node.prev = npos;
+        node.next = freeHead;
+        freeHead = index;
+    }
+
+    /** link a node into the slot matching its expiry*/
+    void place(std::uint32_t index)
+    {
+        auto& node = nodes[index];
+        const auto delta =
+            (node.expiry > currentTick) ? node.expiry - currentTick : 0;
+        int level{0};
+        while (level < levels - 1 &&
+               delta >= (std::uint64_t{1} << (slotBits * (level + 1)))) {
+            ++level;
+        }
+        int slot{0};
+        if (level == levels - 1 &&
+            delta >= (std::uint64_t{1} << (slotBits * levels))) {
+            // out of range, park in the farthest slot of the top level
+            slot = static_cast<int>(
+                ((currentTick >> (slotBits * level)) - 1) & slotMask);
+        } else {
+            slot = static_cast<int>(
+                (node.expiry >> (slotBits * level)) & slotMask);
+        }
+        node.level = level;
+        node.slot = slot;
+        node.prev = npos;
+        node.next = slots[level][slot];
+        if (node.next != npos) {
+            nodes[node.next].prev = index;
+        }
+        slots[level][slot] = index;
+        occupancy[level] |= (std::uint64_t{1} << slot);
+    }
+    /** remove a node from its slot*/
+    void unlink(std::uint32_t index)
+    {
+        auto& node = nodes[index];
+        if (node.prev != npos) {
+            nodes[node.prev].next = node.next;
+        } else {
+            slots[node.level][node.slot] = node.next;
+            if (node.next == npos) {
+                occupancy[node.level] &= ~(std::uint64_t{1} << node.slot);
+            }
+        }
+        if (node.next != npos) {
+            nodes[node.next].prev = node.prev;
+        }
+    }
+    /** detach the list of a slot and return its head*/
+    std::uint32_t takeSlot(int level, int slot)
+    {
+        const auto head = slots[level][slot];
+        slots[level][slot] = npos;
+        occupancy[level] &= ~(std::uint64_t{1} << slot);
+        return head;
+    }
+
+    /** the first tick after the current one at which something happens*/
+    std::optional<std::uint64_t> nextEventTick() const
+    {
+        std::optional<std::uint64_t> next;
+        for (int level = 0; level < levels; ++level) {
+            if (occupancy[level] == 0) {
+                continue;
+            }
+            const int shift = slotBits * level;
+            const auto position = currentTick >> shift;
+            const auto current = static_cast<int>(position & slotMask);
+            // rotate so bit 0 is the slot after the current one
+            const auto rotated = std::rotr(occupancy[level], current + 1);
+            const auto steps =
+                static_cast<std::uint64_t>(std::countr_zero(rotated)) + 1;
+            const auto tick = (position + steps) << shift;
+            if (!next || tick < *next) {
+                next = tick;
+            }
+        }
+        return next;
+    }
+
+    /** cascade the higher levels and fire level 0 for the current tick
+@param[in] onExpired the callback for expired timers
+@param[in] target the tick the wheel is advancing to*/
+    template<typename Callback>
+    void processTick(Callback& onExpired, std::uint64_t target)
+    {
+        int top{0};
+        while (top < levels - 1 &&
+               (currentTick &
+                ((std::uint64_t{1} << (slotBits * (top + 1))) - 1)) == 0) {
+            ++top;
+        }
+        for (int level = top; level >= 1; --level) {
+            const auto slot = static_cast<int>(
+                (currentTick >> (slotBits * level)) & slotMask);
+            auto index = takeSlot(level, slot);
+            while (index != npos) {
+                const auto next = nodes[index].next;
+                place(index);
+                index = next;
+            }
+        }
+        auto index = takeSlot(0, static_cast<int>(currentTick & slotMask));
+        while (index != npos) {
+            const auto next = nodes[index].next;
+            auto& node = nodes[index];
+            if (node.expiry > currentTick) {
+                place(index);
+            } else {
+                onExpired(node.value);
+                if (node.period > 0) {
+                    node.expiry += node.period;
+                    if (node.expiry <= target) {
+                        node.expiry += ((target - node.expiry) /
+                                            node.period +
+                                        1) *
+                            node.period;
+                    }
+                    place(index);
+                } else {
+                    releaseNode(index);
+                    --count;
+                }
+            }
+            index = next;
+        }
+    }
+
+    clock::duration resolution;  //!< the duration of a tick
+    clock::time_point startTime;  //!< the time of tick 0
+    std::uint64_t currentTick{0};  //!< the last processed tick
+    std::vector<Node> nodes;  //!< storage for the timers
+    std::uint32_t freeHead{npos};  //!< first unused node
+    std::array<std::array<std::uint32_t, 64>, levels> slots{};
+    std::array<std::uint64_t, levels> occupancy{};  //!< non-empty slots
+    std::size_t count{0};  //!< the number of pending timers
+};
+
+}  // namespace gmlc::containers
@@ -22,26 +22,403 @@ SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
 #include "SimpleQueue.hpp"
+#include "StableBlockDeque.hpp"
+#include "TimerWheel.hpp"
+#include "WorkerAffinity.hpp"
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <future>
+#include <iomanip>
+#include <iterator>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
 #include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+/** set to 1 to compile in the WorkQueue metrics, see WorkQueue::getMetrics*/
+#ifndef GMLC_CONTAINERS_WORKQUEUE_METRICS
+#    define GMLC_CONTAINERS_WORKQUEUE_METRICS 0
+#endif
+/** set to 1 to compile in the WorkQueue tracing, see WorkQueue::writeTrace*/
+#ifndef GMLC_CONTAINERS_WORKQUEUE_TRACING
+#    define GMLC_CONTAINERS_WORKQUEUE_TRACING 0
+#endif
+
 namespace gmlc::containers {
+/** exception reported by the future of a work block that was cancelled
+before it started*/
+class WorkCancelled : public std::runtime_error {
+  public:
+    WorkCancelled() : std::runtime_error("work was cancelled") {}
+};
+
+namespace detail {
+    /** flag set while the calling thread is cancelling a work block*/
+    inline bool& cancellingWork() noexcept
+    {
+        thread_local bool cancelling{false};
+        return cancelling;
+    }
+    /** sets the cancelling flag of the calling thread for its lifetime*/
+    class CancelScope {
+      public:
+        CancelScope() noexcept { cancellingWork() = true; }
+        ~CancelScope() { cancellingWork() = false; }
+        CancelScope(const CancelScope&) = delete;
+        CancelScope& operator=(const CancelScope&) = delete;
+    };
+    /** wrapper for the function of a work block
+@details while the block is being cancelled it throws WorkCancelled instead of
+calling the function, so the exception is stored in the future of the
+packaged task holding it*/
+    template<typename Func>
+    struct CancellableWork {
+        Func func;
+        decltype(auto) operator()()
+        {
+            if (cancellingWork()) {
+                throw(WorkCancelled());
+            }
+            return func();
+        }
+    };
+    template<typename Func>
+    auto cancellable(Func&& func)
+    {
+        return CancellableWork<std::decay_t<Func>>{std::forward<Func>(func)};
+    }
+
+    /** the deepest nesting of work run by a thread while it waits*/
+    constexpr int maxWaitHelpDepth{8};
+    /** hook letting a waiting pool thread run other queued work
+@details a WorkQueue worker installs it for its thread, runOne takes a single
+task from the queue and runs it, returning false if nothing was queued*/
+    struct WaitHelper {
+        bool (*runOne)(void* context){nullptr};
+        void* context{nullptr};  //!< the queue the thread works for
+        int depth{0};  //!< the number of waits currently helping
+    };
+    /** get the wait helper of the calling thread*/
+    inline WaitHelper& waitHelper() noexcept
+    {
+        thread_local WaitHelper helper;
+        return helper;
+    }
+    /** wait for a future to become ready
+@details on a pool thread other queued work is run until the future is ready,
+which keeps nested waits from blocking the workers they depend on.  Once the
+helping is nested maxWaitHelpDepth deep, and on other threads, the wait
+blocks.*/
+    template<typename Future>
+    void helpWhileWaiting(const Future& future)
+    {
+        auto& helper = waitHelper();
+        if (helper.runOne == nullptr || helper.depth >= maxWaitHelpDepth) {
+            future.wait();
+            return;
+        }
+        auto pause = std::chrono::microseconds(20);
+        while (future.wait_for(std::chrono::seconds(0)) !=
+               std::future_status::ready) {
+            ++helper.depth;
+            bool ran{false};
+            try {
+                ran = helper.runOne(helper.context);
+            }
+            catch (...) {
+                --helper.depth;
+                throw;
+            }
+            --helper.depth;
+            if (ran) {
+                pause = std::chrono::microseconds(20);
+            } else {
+                // nothing to run, the awaited work is running elsewhere
+                future.wait_for(pause);
+                pause = std::min(pause * 2, std::chrono::microseconds(1000));
+            }
+        }
+    }
+
+    /** monotonic arena of a worker thread for the memory of its tasks*/
+    class TaskArena {
+      public:
+        explicit TaskArena(std::size_t size) :
+            buffer(std::make_unique<std::byte[]>(size)),
+            resource(buffer.get(), size)
+        {
+        }
+        std::pmr::memory_resource* memory() { return &resource; }
+        /** called as a task starts*/
+        void enter() { ++depth; }
+        /** called as a task ends, the arena is reset once no task of the
+        thread is running*/
+        void leave()
+        {
+            if (--depth == 0) {
+                resource.release();
+            }
+        }
+
+      private:
+        std::unique_ptr<std::byte[]> buffer;  //!< the initial buffer
+        std::pmr::monotonic_buffer_resource resource;  //!< the arena
+        int depth{0};  //!< tasks running, more than one while helping a wait
+    };
+    /** get the task arena of the calling thread or nullptr*/
+    inline TaskArena*& currentTaskArena() noexcept
+    {
+        thread_local TaskArena* arena{nullptr};
+        return arena;
+    }
+    /** marks a task running on the arena of the calling thread*/
+    class TaskArenaScope {
+      public:
+        TaskArenaScope() noexcept : arena(currentTaskArena())
+        {
+            if (arena != nullptr) {
+                arena->enter();
+            }
+        }
+        ~TaskArenaScope()
+        {
+            if (arena != nullptr) {
+                arena->leave();
+            }
+        }
+        TaskArenaScope(const TaskArenaScope&) = delete;
+        TaskArenaScope& operator=(const TaskArenaScope&) = delete;
+
+      private:
+        TaskArena* arena;
+    };
+
+    /** the execution of a task recorded for a trace*/
+    struct TraceEvent {
+        std::int64_t queued;  //!< nanoseconds when the task was queued
+        std::int64_t start;  //!< nanoseconds when the task started
+        std::int64_t end;  //!< nanoseconds when the task ended
+        std::size_t slot;  //!< the priority or deadline slot of the task
+    };
+    /** bounded log of the latest trace events written by a single thread
+@details the events are stored in fixed size chunks linked in order.  The
+writer fills an event before publishing it through the count of its chunk, so
+a reader sees only complete events.  Once the log holds maxChunks chunks the
+oldest one is reused, so the memory stays bounded while a queue runs for a long
+time.  The lock is taken only to move to the next chunk and by a reader for
+the whole visit, so a chunk is never reused while it is read.*/
+    class TraceBuffer {
+      public:
+        /** the number of events a buffer keeps*/
+        static constexpr std::size_t capacity{65536};
+
+        TraceBuffer() : head(new Chunk), tail(head) {}
+        ~TraceBuffer()
+        {
+            while (head != nullptr) {
+                auto* next = head->next.load();
+                delete head;
+                head = next;
+            }
+        }
+        TraceBuffer(const TraceBuffer&) = delete;
+        TraceBuffer& operator=(const TraceBuffer&) = delete;
+
+        /** add an event, only one thread may call this at a time*/
+        void record(const TraceEvent& event)
+        {
+            auto count = tail->count.load(std::memory_order_relaxed);
+            if (count == chunkSize) {
+                nextChunk();
+                count = 0;
+            }
+            tail->events[count] = event;
+            tail->count.store(count + 1, std::memory_order_release);
+        }
+        /** call a function with each published event in order*/
+        template<typename Visitor>
+        void visit(Visitor&& visitor) const
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (const Chunk* chunk = head; chunk != nullptr;
+                 chunk = chunk->next.load(std::memory_order_acquire)) {
+                const auto count = chunk->count.load(std::memory_order_acquire);
+                for (std::size_t ii = 0; ii < count; ++ii) {
+                    visitor(chunk->events[ii]);
+                }
+            }
+        }
+
+      private:
+        static constexpr std::size_t chunkSize{4096};
+        static constexpr std::size_t maxChunks{capacity / chunkSize};
+        struct Chunk {
+            std::array<TraceEvent, chunkSize> events;
+            std::atomic<std::size_t> count{0};  //!< published events
+            std::atomic<Chunk*> next{nullptr};  //!< the following chunk
+        };
+        /** append a chunk to write to, reusing the oldest once at the limit*/
+        void nextChunk()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            Chunk* chunk{nullptr};
+            if (chunks < maxChunks) {
+                chunk = new Chunk;
+                ++chunks;
+            } else {
+                chunk = head;
+                head = head->next.load(std::memory_order_relaxed);
+                chunk->next.store(nullptr, std::memory_order_relaxed);
+                chunk->count.store(0, std::memory_order_relaxed);
+            }
+            tail->next.store(chunk, std::memory_order_release);
+            tail = chunk;
+        }
+
+        mutable std::mutex lock;  //!< lock protecting the chunk list
+        Chunk* head;  //!< the first chunk
+        Chunk* tail;  //!< the chunk being written
+        std::size_t chunks{1};  //!< the number of chunks in the list
+
+      public:
+        // state of the writing worker
+        std::int64_t lastEnd{0};  //!< end of the last task or 0 after idling
+        int nesting{0};  //!< tasks running on the worker
+    };
+}  // namespace detail
+
 /** basic work block abstract class*/
 class BasicWorkBlock {
   public:
     BasicWorkBlock() noexcept {}
-    virtual ~BasicWorkBlock() = default;
+    virtual ~BasicWorkBlock()
+    {
+        auto* node = continuations.load();
+        while (node != nullptr && node != completedMarker()) {
+            auto* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
     /** run the work block*/
     virtual void execute() = 0;
     /** check if the work is finished
 @return true if the work has been done false otherwise
 */
     virtual bool isFinished() const = 0;
+    /** cancel the work if it has not started
+@details a cancelled block counts as finished so a queue skips it, its future
+reports WorkCancelled and its continuations are run
+@return true if the work was cancelled, false if it had already started or the
+block does not support cancellation
+*/
+    virtual bool cancel() { return false; }
+    /** check if the work was cancelled*/
+    virtual bool isCancelled() const { return false; }
+    /** call a function once the work has completed
+@details the function is called by the thread completing the work, or
+immediately by the calling thread if the work has already completed, so it
+should be short and must not block.  An exception thrown by the function is
+dropped so it cannot reach the thread that completed the work or stop the
+other continuations; a function that can fail has to report the error itself.
+Derived classes must call runContinuations() at the end of execute() for this
+to have any effect.
+@param[in] func a nullary callable
+*/
+    template<typename Func>
+    void onCompletion(Func&& func)
+    {
+        auto node = std::make_unique<ContinuationFunction<std::decay_t<Func>>>(
+            std::forward<Func>(func));
+        auto* head = continuations.load();
+        while (head != completedMarker()) {
+            node->next = head;
+            if (continuations.compare_exchange_weak(head, node.get())) {
+                node.release();
+                return;
+            }
+        }
+        node->run();
+    }
+
+  protected:
+    /** mark the work as completed and run the registered continuations in
+the order they were added*/
+    void runContinuations()
+    {
+        auto* node = continuations.exchange(completedMarker());
+        if (node == completedMarker()) {
+            return;
+        }
+        Continuation* ordered{nullptr};
+        while (node != nullptr) {
+            auto* next = node->next;
+            node->next = ordered;
+            ordered = node;
+            node = next;
+        }
+        while (ordered != nullptr) {
+            std::unique_ptr<Continuation> current(ordered);
+            ordered = current->next;
+            try {
+                current->run();
+            }
+            catch (...) {
+                // the work itself has completed, the thread running it has
+                // no use for the error of a continuation
+            }
+        }
+    }
+    /** allow continuations to be registered again after the work is reset*/
+    void resetContinuations() noexcept
+    {
+        auto* expected = completedMarker();
+        continuations.compare_exchange_strong(expected, nullptr);
+    }
+
+  private:
+    /** node in the list of functions to call on completion*/
+    struct Continuation {
+        Continuation() = default;
+        Continuation(const Continuation&) = delete;
+        Continuation& operator=(const Continuation&) = delete;
+        virtual ~Continuation() = default;
+        virtual void run() {}
+        Continuation* next{nullptr};
+    };
+    template<typename Func>
+    struct ContinuationFunction final : Continuation {
+        template<typename F>
+        explicit ContinuationFunction(F&& function) :
+            func(std::forward<F>(function))
+        {
+        }
+        void run() override { func(); }
+        Func func;
+    };
+    /** get the list head marking that the work has completed*/
+    static Continuation* completedMarker() noexcept
+    {
+        static Continuation marker;
+        return &marker;
+    }
+    std::atomic<Continuation*> continuations{nullptr};
 };
 
 /** a dummy work block that does nothing*/
@@ -64,18 +441,20 @@ class WorkBlock : public BasicWorkBlock {
     /** move constructor*/
     WorkBlock(WorkBlock&& wb) noexcept :
         task(std::move(wb.task)), future_ret(std::move(wb.future_ret)),
-        finished(wb.finished.load()), loaded(wb.loaded)
+        finished(wb.finished.load()), cancelled(wb.cancelled.load()),
+        loaded(wb.loaded), packaged(wb.packaged)
     {
     }
     /** constructor from a packaged task*/
     WorkBlock(std::packaged_task<retType()>&& newTask) :
-        task(std::move(newTask)), loaded(true)
+        task(std::move(newTask)), loaded(true), packaged(true)
     {
         reset();
     }
     /** construct from a some sort of functional object*/
     template<typename Func>  // forwarding reference
-    WorkBlock(Func&& newWork) : task(std::forward<Func>(newWork)), loaded(true)
+    WorkBlock(Func&& newWork) :
+        task(detail::cancellable(std::forward<Func>(newWork))), loaded(true)
     {
         static_assert(
             std::is_same_v<decltype(newWork()), retType>,
@@ -89,7 +468,9 @@ class WorkBlock : public BasicWorkBlock {
             task = std::move(wb.task);
             future_ret = std::move(wb.future_ret);
             finished.store(wb.finished.load());
+            cancelled.store(wb.cancelled.load());
             loaded = wb.loaded;
+            packaged = wb.packaged;
         }
         return *this;
     }
@@ -100,10 +481,48 @@ class WorkBlock : public BasicWorkBlock {
             if (loaded) {
                 task();
             }
+            runContinuations();
+        }
+    }
+    /** cancel the work if it has not started
+@details the future reports WorkCancelled, except for work given as a packaged
+task, whose function cannot be made to throw; that task is dropped so its
+future reports a broken promise and getReturnVal throws WorkCancelled
+@return true if the work was cancelled*/
+    bool cancel() override
+    {
+        if (finished.exchange(true)) {
+            return false;
+        }
+        cancelled.store(true);
+        if (packaged) {
+            task = std::packaged_task<retType()>(
+                []() -> retType { throw(WorkCancelled()); });
+        } else if (loaded) {
+            detail::CancelScope scope;
+            task();
+        }
+        runContinuations();
+        return true;
+    }
+    /** check if the work was cancelled*/
+    bool isCancelled() const override { return cancelled.load(); }
+    /** get the return value,  will block until the task is finished
+@throw WorkCancelled if the work was cancelled*/
+    retType getReturnVal() const
+    {
+        detail::helpWhileWaiting(future_ret);
+        try {
+            return future_ret.get();
+        }
+        catch (const std::future_error&) {
+            // the promise of a cancelled packaged task is broken
+            if (cancelled.load()) {
+                throw(WorkCancelled());
+            }
+            throw;
         }
     }
-    /** get the return value,  will block until the task is finished*/
-    retType getReturnVal() const { return future_ret.get(); }
     /** update the work function
 @param[in] newWork the work to do*/
     template<typename Func>
@@ -113,7 +532,9 @@ class WorkBlock : public BasicWorkBlock {
             std::is_same_v<decltype(newWork()), retType>,
             "work does not match type");
         loaded = false;
-        task = std::packaged_task<retType()>(std::forward<Func>(newWork));
+        task = std::packaged_task<retType()>(
+            detail::cancellable(std::forward<Func>(newWork)));
+        packaged = false;
         reset();
         loaded = true;
     }
@@ -123,13 +544,15 @@ class WorkBlock : public BasicWorkBlock {
     {
         loaded = false;
         task = std::move(newTask);
+        packaged = true;
         reset();
         loaded = true;
     }
     /** check if the task is finished*/
     bool isFinished() const override { return finished.load(); }
-    /** wait until the work is done*/
-    void wait() { future_ret.wait(); }
+    /** wait until the work is done
+@details a WorkQueue worker runs other queued work while it waits*/
+    void wait() const { detail::helpWhileWaiting(future_ret); }
     /** reset the work so it can run again*/
     void reset()
     {
@@ -137,7 +560,9 @@ class WorkBlock : public BasicWorkBlock {
             task.reset();
         }
         finished.store(false);
+        cancelled.store(false);
         future_ret = task.get_future();
+        resetContinuations();
     };
     /** get the shared future object*/
     std::shared_future<retType> get_future() { return future_ret; }
@@ -147,7 +572,10 @@ class WorkBlock : public BasicWorkBlock {
     std::shared_future<retType> future_ret;  //!< shared future object
     std::atomic<bool> finished{
         false};  //!< flag indicating the work has been done
+    std::atomic<bool> cancelled{
+        false};  //!< flag indicating the work was cancelled
     bool loaded = false;  //!< flag indicating that the task is loaded
+    bool packaged = false;  //!< flag indicating the task was given packaged
 };
 
 /** implementation of a workBlock class with void return type
@@ -159,13 +587,14 @@ class WorkBlock<void> : public BasicWorkBlock {
   public:
     WorkBlock() { reset(); }
     WorkBlock(std::packaged_task<void()>&& newTask) :
-        task(std::move(newTask)), loaded(true)
+        task(std::move(newTask)), loaded(true), packaged(true)
     {
         reset();
     }
 
     template<typename Func>
-    WorkBlock(Func&& newWork) : task(std::forward<Func>(newWork)), loaded(true)
+    WorkBlock(Func&& newWork) :
+        task(detail::cancellable(std::forward<Func>(newWork))), loaded(true)
     {
         static_assert(
             std::is_same_v<decltype(newWork()), void>,
@@ -175,7 +604,8 @@ class WorkBlock<void> : public BasicWorkBlock {
 
     WorkBlock(WorkBlock&& wb) noexcept :
         task(std::move(wb.task)), future_ret(std::move(wb.future_ret)),
-        finished(wb.finished.load()), loaded(wb.loaded)
+        finished(wb.finished.load()), cancelled(wb.cancelled.load()),
+        loaded(wb.loaded), packaged(wb.packaged)
     {
     }
     WorkBlock& operator=(WorkBlock&& wb) noexcept
@@ -184,7 +614,9 @@ class WorkBlock<void> : public BasicWorkBlock {
             task = std::move(wb.task);
             future_ret = std::move(wb.future_ret);
             finished.store(wb.finished.load());
+            cancelled.store(wb.cancelled.load());
             loaded = wb.loaded;
+            packaged = wb.packaged;
         }
         return *this;
     }
@@ -194,9 +626,39 @@ class WorkBlock<void> : public BasicWorkBlock {
             if (loaded) {
                 task();
             }
+            runContinuations();
         }
     };
-    void getReturnVal() const { future_ret.wait(); }
+    bool cancel() override
+    {
+        if (finished.exchange(true)) {
+            return false;
+        }
+        cancelled.store(true);
+        if (packaged) {
+            task = std::packaged_task<void()>([] { throw(WorkCancelled()); });
+        } else if (loaded) {
+            detail::CancelScope scope;
+            task();
+        }
+        runContinuations();
+        return true;
+    }
+    bool isCancelled() const override { return cancelled.load(); }
+    void getReturnVal() const
+    {
+        detail::helpWhileWaiting(future_ret);
+        try {
+            future_ret.get();
+        }
+        catch (const std::future_error&) {
+            // the promise of a cancelled packaged task is broken
+            if (cancelled.load()) {
+                throw(WorkCancelled());
+            }
+            throw;
+        }
+    }
 
     template<typename Func>
     void updateWorkFunction(Func&& newWork)
@@ -205,7 +667,9 @@ class WorkBlock<void> : public BasicWorkBlock {
             std::is_same_v<decltype(newWork()), void>,
             "work does not match type");
         loaded = false;
-        task = std::packaged_task<void()>(std::forward<Func>(newWork));
+        task = std::packaged_task<void()>(
+            detail::cancellable(std::forward<Func>(newWork)));
+        packaged = false;
         reset();
         loaded = true;
     }
@@ -213,18 +677,21 @@ class WorkBlock<void> : public BasicWorkBlock {
     {
         loaded = false;
         task = std::move(newTask);
+        packaged = true;
         reset();
         loaded = true;
     }
     bool isFinished() const override { return finished.load(); };
-    void wait() const { future_ret.wait(); }
+    void wait() const { detail::helpWhileWaiting(future_ret); }
     void reset()
     {
         if (loaded) {
             task.reset();
         }
         finished.store(false);
+        cancelled.store(false);
         future_ret = task.get_future();
+        resetContinuations();
     };
     std::shared_future<void> get_future() { return future_ret; }
 
@@ -232,7 +699,9 @@ class WorkBlock<void> : public BasicWorkBlock {
     std::packaged_task<void()> task;
     std::shared_future<void> future_ret;
     std::atomic<bool> finished{false};
+    std::atomic<bool> cancelled{false};
     bool loaded = false;
+    bool packaged = false;
 };
 
 /** make a unique pointer to a workBlock object from a functional object
@@ -276,14 +745,506 @@ auto make_shared_workBlock(std::packaged_task<X()>&& task)
     return std::make_shared<WorkBlock<X>>(std::move(task));
 }
 
+namespace detail {
+    /** pool of fixed size memory blocks for task captures that are too large
+to be stored inline in a WorkTask
+@details each thread keeps a small cache of released blocks so allocating and
+releasing a block normally takes no lock.  A full cache hands half of its
+blocks to a shared depot and an empty cache refills from it, one lock per
+batch, so blocks released on the workers flow back to the submitting threads.
+The depot keeps at most depotLimit blocks and frees the rest, and a thread
+returns its cache to the depot when it exits, so the memory held by the pool
+is bounded.  Blocks released after the depot is destroyed at exit are freed
+directly.
+*/
+    class TaskStoragePool {
+      public:
+        /** the size of each block in the pool*/
+        static constexpr std::size_t blockSize{256};
+        /** the number of blocks cached by each thread*/
+        static constexpr std::size_t cacheLimit{64};
+        /** the number of blocks kept in the shared depot*/
+        static constexpr std::size_t depotLimit{4096};
+
+        /** get a block of blockSize bytes*/
+        static void* allocate()
+        {
+            auto& cache = threadCache();
+            if (cache.count == 0 && cache.active) {
+                cache.refill();
+            }
+            if (cache.count > 0) {
+                return cache.blocks[--cache.count];
+            }
+            return ::operator new(blockSize);
+        }
+        /** return a block to the pool*/
+        static void release(void* ptr) noexcept
+        {
+            auto& cache = threadCache();
+            if (!cache.active) {
+                giveBack(&ptr, 1);
+                return;
+            }
+            if (cache.count == cacheLimit) {
+                cache.count -= cacheLimit / 2;
+                giveBack(cache.blocks.data() + cache.count, cacheLimit / 2);
+            }
+            cache.blocks[cache.count++] = ptr;
+        }
+
+      private:
+        /** the blocks shared between the threads*/
+        struct Depot {
+            Depot() { blocks.reserve(depotLimit); }
+            ~Depot()
+            {
+                closed.store(true);
+                for (auto* block : blocks) {
+                    ::operator delete(block);
+                }
+            }
+            Depot(const Depot&) = delete;
+            Depot& operator=(const Depot&) = delete;
+            std::mutex lock;  //!< lock protecting the blocks
+            std::vector<void*> blocks;  //!< the available blocks
+        };
+        /** the blocks cached by one thread*/
+        struct ThreadCache {
+            ThreadCache() = default;
+            ~ThreadCache()
+            {
+                active = false;
+                giveBack(blocks.data(), count);
+                count = 0;
+            }
+            ThreadCache(const ThreadCache&) = delete;
+            ThreadCache& operator=(const ThreadCache&) = delete;
+            /** take up to half a cache worth of blocks from the depot*/
+            void refill()
+            {
+                if (closed.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                auto& shared = depot();
+                std::lock_guard<std::mutex> depotLock(shared.lock);
+                while (count < cacheLimit / 2 && !shared.blocks.empty()) {
+                    blocks[count++] = shared.blocks.back();
+                    shared.blocks.pop_back();
+                }
+            }
+            std::array<void*, cacheLimit> blocks{};  //!< the cached blocks
+            std::size_t count{0};  //!< the number of cached blocks
+            bool active{true};  //!< false once the thread is exiting
+        };
+
+        static Depot& depot()
+        {
+            static Depot shared;
+            return shared;
+        }
+        static ThreadCache& threadCache() noexcept
+        {
+            thread_local ThreadCache cache;
+            return cache;
+        }
+        /** move blocks to the depot, freeing those that do not fit*/
+        static void giveBack(void** released, std::size_t count) noexcept
+        {
+            std::size_t kept{0};
+            if (!closed.load(std::memory_order_relaxed)) {
+                auto& shared = depot();
+                std::lock_guard<std::mutex> depotLock(shared.lock);
+                kept = std::min(count, depotLimit - shared.blocks.size());
+                shared.blocks.insert(
+                    shared.blocks.end(), released, released + kept);
+            }
+            for (std::size_t ii = kept; ii < count; ++ii) {
+                ::operator delete(released[ii]);
+            }
+        }
+
+        /** set once the depot has been destroyed*/
+        static inline std::atomic<bool> closed{false};
+    };
+}  // namespace detail
+
+/** move only type erased nullary callable used as the WorkQueue element
+@details callables up to inlineSize bytes are stored in the object itself,
+larger ones are placed in a block from a shared pool that is reused once
+released, so fire and forget work does not allocate in steady state.  A
+WorkTask can also wrap a shared BasicWorkBlock which is executed if it is not
+already finished.
+*/
+class WorkTask {
+  public:
+    /** the largest callable stored without going to the pool*/
+    static constexpr std::size_t inlineSize{64 - sizeof(void*)};
+
+    WorkTask() noexcept = default;
+    /** construct from a callable object*/
+    template<
+        typename Func,
+        typename = std::enable_if_t<
+            !std::is_same_v<std::decay_t<Func>, WorkTask> &&
+            !std::is_convertible_v<Func, std::shared_ptr<BasicWorkBlock>>>>
+    WorkTask(Func&& func)  // NOLINT(bugprone-forwarding-reference-overload)
+    {
+        emplace<std::decay_t<Func>>(std::forward<Func>(func));
+    }
+    /** construct from a work block*/
+    WorkTask(std::shared_ptr<BasicWorkBlock> block)
+    {
+        if (block) {
+            emplace<BlockRunner>(BlockRunner{std::move(block)});
+        }
+    }
+    WorkTask(WorkTask&& task) noexcept : ops(task.ops)
+    {
+        if (ops != nullptr) {
+            ops->relocate(storage, task.storage);
+            task.ops = nullptr;
+        }
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS || GMLC_CONTAINERS_WORKQUEUE_TRACING
+        queuedAt = task.queuedAt;
+        queuedPriority = task.queuedPriority;
+#endif
+    }
+    WorkTask& operator=(WorkTask&& task) noexcept
+    {
+        if (this != &task) {
+            reset();
+            if (task.ops != nullptr) {
+                task.ops->relocate(storage, task.storage);
+                ops = task.ops;
+                task.ops = nullptr;
+            }
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS || GMLC_CONTAINERS_WORKQUEUE_TRACING
+            queuedAt = task.queuedAt;
+            queuedPriority = task.queuedPriority;
+#endif
+        }
+        return *this;
+    }
+    WorkTask(const WorkTask&) = delete;
+    WorkTask& operator=(const WorkTask&) = delete;
+    ~WorkTask() { reset(); }
+
+    /** run the task*/
+    void operator()() { ops->invoke(storage); }
+    /** check if the task contains something to run*/
+    explicit operator bool() const noexcept { return ops != nullptr; }
+    /** get the work block if the task wraps one
+@return the block or an empty pointer if the task is not a work block*/
+    std::shared_ptr<BasicWorkBlock> getBlock() const
+    {
+        if (ops == &inlineOperations<BlockRunner>) {
+            return std::launder(reinterpret_cast<const BlockRunner*>(storage))
+                ->block;
+        }
+        return nullptr;
+    }
+    /** destroy the stored callable*/
+    void reset() noexcept
+    {
+        if (ops != nullptr) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+  private:
+    /** runner for a shared work block*/
+    struct BlockRunner {
+        std::shared_ptr<BasicWorkBlock> block;
+        void operator()() const
+        {
+            if (!block->isFinished()) {
+                block->execute();
+            }
+        }
+    };
+    /** table of the type specific operations*/
+    struct Operations {
+        void (*invoke)(void* data);
+        void (*relocate)(void* destination, void* source) noexcept;
+        void (*destroy)(void* data) noexcept;
+    };
+
+    template<typename F>
+    static constexpr bool storedInline = sizeof(F) <= inlineSize &&
+        alignof(F) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible_v<F>;
+    template<typename F>
+    static constexpr bool storedInPool =
+        sizeof(F) <= detail::TaskStoragePool::blockSize &&
+        alignof(F) <= alignof(std::max_align_t);
+
+    template<typename F, typename... Args>
+    void emplace(Args&&... args)
+    {
+        if constexpr (storedInline<F>) {
+            ::new (static_cast<void*>(storage)) F(std::forward<Args>(args)...);
+            ops = &inlineOperations<F>;
+        } else {
+            F* func{nullptr};
+            if constexpr (storedInPool<F>) {
+                void* block = detail::TaskStoragePool::allocate();
+                try {
+                    func = ::new (block) F(std::forward<Args>(args)...);
+                }
+                catch (...) {
+                    detail::TaskStoragePool::release(block);
+                    throw;
+                }
+            } else {
+                func = new F(std::forward<Args>(args)...);
+            }
+            ::new (static_cast<void*>(storage)) F*(func);
+            ops = &remoteOperations<F>;
+        }
+    }
+
+    template<typename F>
+    static F* inlinePointer(void* data)
+    {
+        return std::launder(static_cast<F*>(data));
+    }
+    template<typename F>
+    static F* remotePointer(void* data)
+    {
+        return *std::launder(static_cast<F**>(data));
+    }
+
+    template<typename F>
+    static constexpr Operations inlineOperations{
+        [](void* data) { (*inlinePointer<F>(data))(); },
+        [](void* destination, void* source) noexcept {
+            F* func = inlinePointer<F>(source);
+            ::new (destination) F(std::move(*func));
+            func->~F();
+        },
+        [](void* data) noexcept { inlinePointer<F>(data)->~F(); }};
+
+    template<typename F>
+    static constexpr Operations remoteOperations{
+        [](void* data) { (*remotePointer<F>(data))(); },
+        [](void* destination, void* source) noexcept {
+            ::new (destination) F*(remotePointer<F>(source));
+        },
+        [](void* data) noexcept {
+            F* func = remotePointer<F>(data);
+            if constexpr (storedInPool<F>) {
+                func->~F();
+                detail::TaskStoragePool::release(func);
+            } else {
+                delete func;
+            }
+        }};
+
+    alignas(std::max_align_t) unsigned char storage[inlineSize];
+    const Operations* ops{nullptr};  //!< operations for the stored type
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS || GMLC_CONTAINERS_WORKQUEUE_TRACING
+    friend class WorkQueue;
+    std::int64_t queuedAt{0};  //!< nanoseconds when the task was queued
+    std::size_t queuedPriority{0};  //!< the priority it was queued with
+#endif
+};
+
+/** counts of durations in power of two buckets*/
+struct DurationHistogram {
+    /** the number of buckets*/
+    static constexpr std::size_t bucketCount{40};
+    /** bucket 0 counts zero durations, bucket i counts durations of at least
+    2^(i-1) and less than 2^i nanoseconds, the last bucket also counts all
+    longer durations*/
+    std::array<std::uint64_t, bucketCount> buckets{};
+    std::uint64_t count{0};  //!< the number of recorded durations
+    std::chrono::nanoseconds total{0};  //!< the sum of the durations
+    std::chrono::nanoseconds max{0};  //!< the longest duration
+
+    /** get the bucket a duration in nanoseconds is counted in*/
+    static std::size_t bucketOf(std::int64_t nanoseconds)
+    {
+        if (nanoseconds <= 0) {
+            return 0;
+        }
+        const auto width = static_cast<std::size_t>(
+            std::bit_width(static_cast<std::uint64_t>(nanoseconds)));
+        return std::min(width, bucketCount - 1);
+    }
+    /** get the mean duration*/
+    std::chrono::nanoseconds mean() const
+    {
+        return (count > 0) ? total / static_cast<std::int64_t>(count) :
+                             std::chrono::nanoseconds(0);
+    }
+    /** estimate a percentile
+@param[in] fraction the percentile as a fraction between 0 and 1
+@return the upper bound of the bucket containing the percentile, limited to
+the longest recorded duration*/
+    std::chrono::nanoseconds percentile(double fraction) const
+    {
+        if (count == 0) {
+            return std::chrono::nanoseconds(0);
+        }
+        const auto rank = static_cast<std::uint64_t>(
+            std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count - 1));
+        std::uint64_t seen{0};
+        for (std::size_t ii = 0; ii < bucketCount; ++ii) {
+            seen += buckets[ii];
+            if (seen > rank) {
+                return std::min(
+                    std::chrono::nanoseconds(std::int64_t{1} << ii), max);
+            }
+        }
+        return max;
+    }
+};
+
+namespace detail {
+    /** histogram of durations that can be updated concurrently*/
+    struct AtomicHistogram {
+        std::array<std::atomic<std::uint64_t>, DurationHistogram::bucketCount>
+            buckets{};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::int64_t> total{0};
+        std::atomic<std::int64_t> max{0};
+
+        /** record a duration in nanoseconds*/
+        void record(std::int64_t nanoseconds) noexcept
+        {
+            buckets[DurationHistogram::bucketOf(nanoseconds)].fetch_add(
+                1, std::memory_order_relaxed);
+            count.fetch_add(1, std::memory_order_relaxed);
+            total.fetch_add(nanoseconds, std::memory_order_relaxed);
+            auto longest = max.load(std::memory_order_relaxed);
+            while (nanoseconds > longest &&
+                   !max.compare_exchange_weak(
+                       longest, nanoseconds, std::memory_order_relaxed)) {
+            }
+        }
+        /** add the recorded durations to a snapshot*/
+        void addTo(DurationHistogram& histogram) const
+        {
+            for (std::size_t ii = 0; ii < DurationHistogram::bucketCount;
+                 ++ii) {
+                histogram.buckets[ii] +=
+                    buckets[ii].load(std::memory_order_relaxed);
+            }
+            histogram.count += count.load(std::memory_order_relaxed);
+            histogram.total += std::chrono::nanoseconds(
+                total.load(std::memory_order_relaxed));
+            histogram.max = std::max(
+                histogram.max,
+                std::chrono::nanoseconds(max.load(std::memory_order_relaxed)));
+        }
+    };
+}  // namespace detail
+/** handle to a work block added to a WorkQueue
+@details the handle does not keep the block alive*/
+class WorkHandle {
+  public:
+    WorkHandle() = default;
+    explicit WorkHandle(const std::shared_ptr<BasicWorkBlock>& workBlock) :
+        block(workBlock)
+    {
+    }
+    /** cancel the work if it has not started
+@return true if the work was cancelled*/
+    bool cancel()
+    {
+        auto work = block.lock();
+        return work && work->cancel();
+    }
+    /** check if the work was cancelled*/
+    bool isCancelled() const
+    {
+        auto work = block.lock();
+        return work && work->isCancelled();
+    }
+
+  private:
+    std::weak_ptr<BasicWorkBlock> block;  //!< the submitted block
+};
+
+/** token shared by a group of work so the group can be cancelled at once
+@details copies of a token refer to the same group.  Cancelling is O(1), work
+of the group still in a queue is dropped when it is taken out, work blocks are
+cancelled at that point so their futures report WorkCancelled.  Work that has
+already started is not interrupted.
+*/
+class CancellationToken {
+  public:
+    CancellationToken() : state(std::make_shared<std::atomic<bool>>(false)) {}
+    /** cancel all work submitted with the token*/
+    void cancel() noexcept { state->store(true, std::memory_order_release); }
+    /** check if the token has been cancelled*/
+    bool isCancelled() const noexcept
+    {
+        return state->load(std::memory_order_acquire);
+    }
+
+  private:
+    friend class WorkQueue;
+    std::shared_ptr<std::atomic<bool>> state;  //!< the shared cancel flag
+};
+
 /** the default ratio between med and low priority tasks*/
 constexpr int defaultPriorityRatio{4};
 
+/** bounds and thresholds for a WorkQueue with a varying number of workers
+@details the queue starts minWorkers threads.  When work is submitted while
+no worker is idle and either more than queueDepthThreshold blocks per worker
+are waiting or no worker has picked up a block within waitThreshold, another
+worker is started, up to maxWorkers.  Workers above minWorkers exit after
+being idle for idleTimeout.  The first reservedWorkers workers only execute
+high and required priority work, so that work does not wait behind long
+running medium and low priority blocks.  The reservation is limited to one
+less than minWorkers so at least one running worker takes the other work.
+*/
+struct WorkerScaling {
+    int minWorkers{0};  //!< the number of workers always running
+    int maxWorkers{1};  //!< the largest number of workers
+    std::size_t queueDepthThreshold{2};  //!< queued blocks per worker
+    std::chrono::milliseconds waitThreshold{
+        10};  //!< time without a worker taking work before growing
+    std::chrono::milliseconds idleTimeout{
+        1000};  //!< idle time before a worker above the minimum exits
+    int reservedWorkers{0};  //!< workers only executing high priority work
+    /** bytes in the initial buffer of the task arena of each worker, 0 to
+    not use task arenas*/
+    std::size_t taskArenaSize{64 * 1024};
+
+    /** scaling for a fixed number of workers*/
+    static WorkerScaling fixed(int workerCount)
+    {
+        WorkerScaling scaling;
+        scaling.minWorkers = workerCount;
+        scaling.maxWorkers = workerCount;
+        return scaling;
+    }
+    /** scaling between a minimum and maximum number of workers*/
+    static WorkerScaling elastic(int minimum, int maximum)
+    {
+        WorkerScaling scaling;
+        scaling.minWorkers = minimum;
+        scaling.maxWorkers = maximum;
+        return scaling;
+    }
+};
+
+template<typename Key, typename Hash>
+class StrandExecutor;
+
 /** class defining a work queuing system
 implemented with 3 priority levels high medium and low
 high is executed as a soon as possible in order
 medium is executed with X times more frequently than low with X being defined by
 the priority ratio
+@details in the workStealing scheduling mode each worker also owns a deque for
+each priority level, work added from a worker thread goes to that worker's own
+deque and idle workers steal from the others in a randomized order
 */
 class WorkQueue {
   public:
@@ -298,20 +1259,71 @@ class WorkQueue {
         required,  //!< high priority work job that always is scheduled
     };
 
+    /** enumeration defining how work is distributed to the workers*/
+    enum class SchedulingMode {
+        shared,  //!< all workers pull from the shared priority queues
+        workStealing,  //!< each worker has its own deques and steals from the
+                       //!< others when they are empty
+    };
+
     /** construct a queue
 @param[in] threadCount  the number of threads in the queue (<0 for default
 value)
+@param[in] mode the scheduling mode used to distribute work to the workers
+@param[in] affinity the placement of the workers on the processors
+@throw std::invalid_argument if a cpu set is requested without any valid cpu
 */
-    explicit WorkQueue(int threadCount) :
-        numWorkers(
-            (threadCount >= 0) ?
-                threadCount :
-                static_cast<int>(std::thread::hardware_concurrency()) + 1)
+    explicit WorkQueue(
+        int threadCount,
+        SchedulingMode mode = SchedulingMode::shared,
+        const WorkerAffinity& affinity = WorkerAffinity{}) :
+        WorkQueue(
+            WorkerScaling::fixed(
+                (threadCount >= 0) ?
+                    threadCount :
+                    static_cast<int>(std::thread::hardware_concurrency()) +
+                        1),
+            mode,
+            affinity)
     {
-        if (numWorkers != 0) {
-            threadpool.resize(numWorkers);
-            for (int kk = 0; kk < numWorkers; ++kk) {
-                threadpool[kk] = std::thread(&WorkQueue::workerLoop, this);
+    }
+    /** construct a queue with a varying number of workers
+@param[in] scaling the worker bounds and the thresholds for adding and
+removing workers, the maximum is raised to the minimum if needed
+@param[in] mode the scheduling mode used to distribute work to the workers
+@param[in] affinity the placement of the workers on the processors
+*/
+    explicit WorkQueue(
+        const WorkerScaling& scaling,
+        SchedulingMode mode = SchedulingMode::shared,
+        const WorkerAffinity& affinity = WorkerAffinity{}) :
+        minWorkers(std::max(scaling.minWorkers, 0)),
+        maxWorkers(std::max(scaling.maxWorkers, minWorkers)),
+        reservedWorkers(
+            std::max(std::min(scaling.reservedWorkers, minWorkers - 1), 0)),
+        schedulingMode(mode), scalingLimits(scaling)
+    {
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS
+        metricCounters = std::make_unique<MetricCounters[]>(maxWorkers + 1);
+#endif
+#if GMLC_CONTAINERS_WORKQUEUE_TRACING
+        traceBuffers = std::make_unique<detail::TraceBuffer[]>(maxWorkers);
+#endif
+        if (maxWorkers != 0) {
+            placeWorkers(affinity);
+            if (schedulingMode == SchedulingMode::workStealing) {
+                localWork.reserve(maxWorkers);
+                for (int kk = 0; kk < maxWorkers; ++kk) {
+                    localWork.push_back(std::make_unique<LocalWorkDeque>());
+                }
+            }
+            threadpool.resize(maxWorkers);
+            workerRunning.assign(maxWorkers, false);
+            lastProgress.store(
+                std::chrono::steady_clock::now().time_since_epoch().count());
+            std::lock_guard<std::mutex> poolGuard(poolLock);
+            for (int kk = 0; kk < minWorkers; ++kk) {
+                startWorker(kk);
             }
         }
     }
@@ -324,32 +1336,264 @@ value)
         if (!halt) {
             closeWorkerQueue();
         }
+        queueLink->detach();
     }
 
     /** get the number of workers
 @return int with the current worker count
 */
-    int getWorkerCount() { return (!halt) ? numWorkers : 0; }
-    /** destroy the WorkQueue*/
-    void closeWorkerQueue()
+    int getWorkerCount() { return (!halt) ? activeWorkers.load() : 0; }
+    /** get the smallest number of workers the queue keeps running*/
+    int getMinWorkerCount() const { return minWorkers; }
+    /** get the largest number of workers the queue will start*/
+    int getMaxWorkerCount() const { return maxWorkers; }
+    /** get the number of workers reserved for high priority work*/
+    int getReservedWorkerCount() const { return reservedWorkers; }
+    /** get the scheduling mode of the queue*/
+    SchedulingMode getSchedulingMode() const { return schedulingMode; }
+    /** get the memory resource for temporary allocations of the running task
+@details on a worker this is a monotonic arena owned by the worker, allocating
+from it is a pointer bump and deallocating does nothing.  The arena is reset
+once the task the worker took from the queue returns, so the memory must not
+be used after that, including after a coroutine task suspends.  Allocations
+beyond WorkerScaling::taskArenaSize come from the default memory resource
+until the reset.  On other threads, and if task arenas are disabled, this is
+the default memory resource.*/
+    static std::pmr::memory_resource* taskMemory()
     {
-        std::unique_lock<std::mutex> lv(queueLock);
+        auto* arena = detail::currentTaskArena();
+        return (arena != nullptr) ? arena->memory() :
+                                    std::pmr::get_default_resource();
+    }
+    /** get the cpus a worker is pinned to
+@return the cpus or an empty vector if the worker is not pinned*/
+    std::vector<int> getWorkerCpus(int index) const
+    {
+        if (index < 0 || index >= static_cast<int>(workerCpus.size())) {
+            return {};
+        }
+        return workerCpus[index];
+    }
+    /** check if work is queued by the NUMA node of the submitting thread*/
+    bool hasNumaLocalSubmission() const { return !nodeWork.empty(); }
+
+    /** true if the metrics are compiled in*/
+    static constexpr bool metricsEnabled{
+        GMLC_CONTAINERS_WORKQUEUE_METRICS != 0};
+    /** snapshot of the metrics of a queue*/
+    struct Metrics {
+        /** the durations recorded for one priority*/
+        struct PriorityMetrics {
+            DurationHistogram queueWait;  //!< time waiting in the queue
+            DurationHistogram execution;  //!< time executing on a worker
+        };
+        /** the metrics of each priority indexed by WorkPriority*/
+        std::array<PriorityMetrics, 4> priorities;
+        PriorityMetrics deadline;  //!< the metrics of the deadline lane
+        std::chrono::nanoseconds busyTime{0};  //!< time workers were executing
+        std::chrono::nanoseconds workerTime{0};  //!< time workers were running
+
+        /** get the metrics of a priority*/
+        const PriorityMetrics& operator[](WorkPriority priority) const
+        {
+            return priorities[static_cast<std::size_t>(priority)];
+        }
+        /** get the fraction of their running time the workers were busy*/
+        double utilization() const
+        {
+            return (workerTime.count() > 0) ?
+                static_cast<double>(busyTime.count()) /
+                    static_cast<double>(workerTime.count()) :
+                0.0;
+        }
+        /** get the number of medium priority blocks taken from the queue per
+low priority block, this matches the priority ratio while both are queued*/
+        double achievedPriorityRatio() const
+        {
+            const auto low = (*this)[WorkPriority::low].queueWait.count;
+            return (low > 0) ?
+                static_cast<double>(
+                    (*this)[WorkPriority::medium].queueWait.count) /
+                    static_cast<double>(low) :
+                0.0;
+        }
+    };
+    /** get a snapshot of the metrics
+@details the queue wait is measured from submission until the work is taken
+from the queue and the execution time for work run by the workers.  Nothing is
+measured unless GMLC_CONTAINERS_WORKQUEUE_METRICS is defined to 1; otherwise
+the returned snapshot is empty.
+*/
+    Metrics getMetrics() const
+    {
+        Metrics snapshot;
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS
+        const auto now = metricClock();
+        std::int64_t busy{0};
+        std::int64_t running{retiredWorkerTime.load()};
+        for (int ii = 0; ii <= maxWorkers; ++ii) {
+            const auto& counters = metricCounters[ii];
+            for (std::size_t pp = 0; pp < snapshot.priorities.size(); ++pp) {
+                counters.queueWait[pp].addTo(
+                    snapshot.priorities[pp].queueWait);
+                counters.execution[pp].addTo(
+                    snapshot.priorities[pp].execution);
+            }
+            counters.queueWait[deadlineSlot].addTo(
+                snapshot.deadline.queueWait);
+            counters.execution[deadlineSlot].addTo(
+                snapshot.deadline.execution);
+            busy += counters.busy.load(std::memory_order_relaxed);
+            const auto started = counters.startedAt.load();
+            if (started != 0) {
+                running += now - started;
+            }
+        }
+        snapshot.busyTime = std::chrono::nanoseconds(busy);
+        snapshot.workerTime = std::chrono::nanoseconds(running);
+#endif
+        return snapshot;
+    }
+
+    /** true if the tracing is compiled in*/
+    static constexpr bool tracingEnabled{
+        GMLC_CONTAINERS_WORKQUEUE_TRACING != 0};
+    /** turn the recording of the trace on or off while the queue runs
+@details recording is on from construction when the tracing is compiled in.
+Recording reads the clock when a task is queued and when it ends, the start
+reuses the end of the previous task while the worker stays busy.  That is about
+75 ns per task in the WorkQueue benchmarks, above the 50 ns aimed for; the
+queued time is kept as it is what shows how long each task waited.  A task is
+recorded if it ends while the recording is on.  With only the tracing compiled
+in it must also have been queued while the recording was on, and turning the
+recording off stops the clock reads.  Without the tracing compiled in this
+does nothing.
+@param[in] enabled set to record the tasks, false to stop recording them*/
+    void setTracing(bool enabled)
+    {
+#if GMLC_CONTAINERS_WORKQUEUE_TRACING
+        tracingActive.store(enabled, std::memory_order_relaxed);
+#else
+        (void)enabled;
+#endif
+    }
+    /** write the recorded task executions as Chrome trace event JSON
+@details with GMLC_CONTAINERS_WORKQUEUE_TRACING defined to 1 each worker
+records the time every task it runs was queued, started, and ended along with
+its priority in a buffer only that worker writes to.  A worker keeps up to its
+latest detail::TraceBuffer::capacity events, older ones are overwritten, so the
+memory used stays bounded.  The output can be loaded in Perfetto or
+chrome://tracing, each worker is a thread with a complete event per task and
+the time spent in the queue is an async event.  Times are in microseconds
+since the queue was constructed.  Tasks completing while the trace is written
+may be missing, a worker moving to a new chunk of its buffer waits until the
+writing is done, and without tracing the event list is empty.
+@param[out] out the stream to write the JSON to
+*/
+    void writeTrace(std::ostream& out) const
+    {
+        out << "{\"traceEvents\":[";
+#if GMLC_CONTAINERS_WORKQUEUE_TRACING
+        static constexpr std::array<const char*, deadlineSlot + 1> names{
+            "medium", "low", "high", "required", "deadline"};
+        const auto flags = out.flags();
+        const auto fill = out.fill();
+        auto writeTime = [this, &out](std::int64_t time) {
+            const auto elapsed = std::max<std::int64_t>(time - traceOrigin, 0);
+            out << elapsed / 1000 << '.' << std::setw(3) << std::setfill('0')
+                << elapsed % 1000;
+        };
+        bool first{true};
+        std::uint64_t id{0};
+        for (int worker = 0; worker < maxWorkers; ++worker) {
+            out << (first ? "\n" : ",\n")
+                << R"({"name":"thread_name","ph":"M","pid":1,"tid":)"
+                << worker << R"(,"args":{"name":"worker )" << worker
+                << "\"}}";
+            first = false;
+            traceBuffers[worker].visit([&](const detail::TraceEvent& event) {
+                const char* name = names[event.slot];
+                ++id;
+                out << ",\n{\"name\":\"" << name
+                    << R"(","cat":"task","ph":"X","pid":1,"tid":)" << worker
+                    << ",\"ts\":";
+                writeTime(event.start);
+                out << ",\"dur\":";
+                writeTime(traceOrigin + event.end - event.start);
+                out << "},\n{\"name\":\"" << name
+                    << R"(","cat":"queued","ph":"b","pid":1,"tid":)" << worker
+                    << ",\"id\":" << id << ",\"ts\":";
+                writeTime(event.queued);
+                out << "},\n{\"name\":\"" << name
+                    << R"(","cat":"queued","ph":"e","pid":1,"tid":)" << worker
+                    << ",\"id\":" << id << ",\"ts\":";
+                writeTime(event.start);
+                out << '}';
+            });
+        }
+        out.flags(flags);
+        out.fill(fill);
+#endif
+        out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    }
+    /** destroy the WorkQueue*/
+    void closeWorkerQueue()
+    {
+        std::unique_lock<std::mutex> lv(queueLock);
         if (!halt.load()) {
             halt.store(true);
             lv.unlock();
+            stopTimers();
             auto dummyWork = std::make_shared<NullWorkBlock>();
 
             workToDoHigh.clear();
             workToDoMed.clear();
             workToDoLow.clear();
+            {
+                std::lock_guard<std::mutex> deadlineGuard(deadlineLock);
+                deadlineWork.clear();
+                deadlineCount.store(0);
+            }
+            for (auto& local : localWork) {
+                std::lock_guard<std::mutex> localLock(local->lock);
+                for (auto& lane : local->lanes) {
+                    lane.clear();
+                }
+                local->count.store(0);
+            }
+            for (auto& node : nodeWork) {
+                for (auto& lane : node->lanes) {
+                    lane.clear();
+                }
+            }
+
+            highQueued.store(0);
+            queuedTasks.store(0);
+            {
+                std::lock_guard<std::mutex> batchGuard(batchLock);
+                for (auto& buffer : batchBuffers) {
+                    std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+                    for (auto& lane : buffer->lanes) {
+                        lane.clear();
+                    }
+                }
+                pendingBatches.store(0);
+            }
 
             queueCondition.notify_all();
-            for (int ii = 0; ii < numWorkers; ++ii) {
+            reservedCondition.notify_all();
+            for (int ii = 0; ii < maxWorkers; ++ii) {
                 addWorkBlock(dummyWork, WorkPriority::required);
             }
             queueCondition.notify_all();
+            reservedCondition.notify_all();
+        }
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> poolGuard(poolLock);
+            threads.swap(threadpool);
         }
-        for (auto& thrd : threadpool) {
+        for (auto& thrd : threads) {
             if (thrd.joinable()) {
                 thrd.join();
             }
@@ -361,79 +1605,516 @@ value)
 @param[in] priority specify the priority of the work, can be low,
 medium(default), or high.  High is always done first, low and medium
 alternate with medium jobs executing more often
+@details in the workStealing mode work added from one of the workers of this
+queue is placed on that worker's own deque
+@return a handle that can cancel the work before it starts
 */
-    void addWorkBlock(
+    WorkHandle addWorkBlock(
         std::shared_ptr<BasicWorkBlock> newWork,
         WorkPriority priority = WorkPriority::medium)
     {
         if ((!newWork) ||
             (newWork->isFinished() && priority != WorkPriority::required)) {
-            return;
+            return WorkHandle(newWork);
         }
-        {
-            std::lock_guard<std::mutex> guard(queueLock);
-            if (halt.load()) {
-                return;
-            }
-        }
-        if (numWorkers > 0) {
-            size_t ccount;
-            switch (priority) {
-                case WorkPriority::high:
-                case WorkPriority::required:
-                    ccount = workToDoHigh.size();
-                    workToDoHigh.push(std::move(newWork));
-                    break;
-                case WorkPriority::medium:
-                    ccount = workToDoMed.size();
-                    workToDoMed.push(std::move(newWork));
-                    break;
-                case WorkPriority::low:
-                default:
-                    ccount = workToDoLow.size();
-                    workToDoLow.push(std::move(newWork));
-                    break;
-            }
-            if (static_cast<int>(ccount) <= numWorkers) {
-                queueCondition.notify_one();
-            }
-        } else {
-            newWork->execute();
+        WorkHandle handle(newWork);
+        addTaskInternal(WorkTask(std::move(newWork)), priority);
+        return handle;
+    }
+    /** add a block of work belonging to a cancellation group
+@details if the token is cancelled before the block is taken from the queue
+the block is cancelled instead of executed
+@param[in] newWork  the block of new work for the queue
+@param[in] priority the priority of the work
+@param[in] group the token of the group the work belongs to
+@return a handle that can cancel the work before it starts
+*/
+    WorkHandle addWorkBlock(
+        std::shared_ptr<BasicWorkBlock> newWork,
+        WorkPriority priority,
+        const CancellationToken& group)
+    {
+        if ((!newWork) || newWork->isFinished()) {
+            return WorkHandle(newWork);
         }
+        WorkHandle handle(newWork);
+        addTaskInternal(
+            WorkTask(GroupBlockRunner{std::move(newWork), group.state}),
+            priority);
+        return handle;
     }
-    /** add a block of work to the WorkQueue
+    /** add a batch of work blocks to the WorkQueue
+@details the shared pointers are copied, blocks that are already finished are
+skipped
 @param[in] newWork  a vector of workBlocks to add to the queue
+@param[in] priority the priority of the work
 */
     void addWorkBlock(
         std::vector<std::shared_ptr<BasicWorkBlock>>& newWork,
         WorkPriority priority = WorkPriority::medium)
     {
+        std::vector<WorkTask> tasks;
+        tasks.reserve(newWork.size());
+        for (const auto& wb : newWork) {
+            if (wb && !wb->isFinished()) {
+                tasks.emplace_back(wb);
+            }
+        }
+        addTaskBatch(std::move(tasks), priority);
+    }
+    /** move a batch of work blocks into the WorkQueue
+@details the whole batch is added to its lane under a single lock and at most
+one sleeping worker per block is woken.  Blocks that are already finished are
+skipped.
+@param[in] newWork  a vector of workBlocks to add to the queue, it is left
+empty
+@param[in] priority the priority of the work
+*/
+    void addWorkBlock(
+        std::vector<std::shared_ptr<BasicWorkBlock>>&& newWork,
+        WorkPriority priority = WorkPriority::medium)
+    {
+        std::vector<WorkTask> tasks;
+        tasks.reserve(newWork.size());
+        for (auto& wb : newWork) {
+            if (wb && !wb->isFinished()) {
+                tasks.emplace_back(std::move(wb));
+            }
+        }
+        newWork.clear();
+        addTaskBatch(std::move(tasks), priority);
+    }
+    /** add a fire and forget task to the WorkQueue
+@details callables that fit in WorkTask::inlineSize bytes are stored directly
+in the queue slot and larger ones in pooled storage, so unlike a WorkBlock no
+allocation is needed in steady state.  There is no future, any result has to
+be communicated by the callable itself, and an exception thrown by the
+callable is dropped and counted by getTaskErrorCount.
+@param[in] task a nullary callable to execute
+@param[in] priority the priority of the work
+@return false if the queue is closed and the task was dropped
+*/
+    template<typename Func>
+    bool addTask(Func&& task, WorkPriority priority = WorkPriority::medium)
+    {
+        return addTaskInternal(WorkTask(std::forward<Func>(task)), priority);
+    }
+    /** add a fire and forget task belonging to a cancellation group
+@details the task is dropped without running if the token is cancelled
+before the task is taken from the queue
+@param[in] task a nullary callable to execute
+@param[in] priority the priority of the work
+@param[in] group the token of the group the task belongs to
+@return false if the queue is closed and the task was dropped
+*/
+    template<typename Func>
+    bool addTask(
+        Func&& task,
+        WorkPriority priority,
+        const CancellationToken& group)
+    {
+        return addTaskInternal(
+            WorkTask([func = std::forward<Func>(task),
+                      cancelled = group.state]() mutable {
+                if (!cancelled->load(std::memory_order_acquire)) {
+                    func();
+                }
+            }),
+            priority);
+    }
+    /** add a small fire and forget task that is queued together with others
+@details the tasks a thread adds this way are buffered per thread and priority
+and queued as a single block once the count set with setBatchLimits is
+reached or the first buffered task has waited longer than the delay, when
+flushBatches is called, or when an awake worker runs out of other work.
+Adding a task does not wake a sleeping worker, so a burst fills its block.
+The delay is checked as tasks are added and by the timer thread, so a partial
+block is queued within a timer tick of its delay even while the workers are
+busy and no more tasks are added.  A worker runs all the tasks of a block in
+the order they were added.  As with addTask an exception thrown by the
+callable is dropped and counted, the other tasks of the block still run.
+@param[in] task a nullary callable to execute
+@param[in] priority the priority of the work
+*/
+    template<typename Func>
+    void addBatchedTask(
+        Func&& task,
+        WorkPriority priority = WorkPriority::medium)
+    {
+        if (maxWorkers == 0) {
+            addTask(std::forward<Func>(task), priority);
+            return;
+        }
+        auto& buffer = batchBuffer();
+        const auto lane = laneIndex(priority);
+        const auto limit = batchCountLimit.load(std::memory_order_relaxed);
+        std::vector<WorkTask> full;
+        bool started{false};
         {
-            std::lock_guard<std::mutex> guard(queueLock);
-            if (halt.load()) {
-                return;
+            std::lock_guard<std::mutex> guard(buffer.lock);
+            auto& tasks = buffer.lanes[lane];
+            if (tasks.empty()) {
+                buffer.firstAdded[lane] = std::chrono::steady_clock::now();
+                tasks.reserve(limit);
+                started = true;
+            }
+            tasks.emplace_back(std::forward<Func>(task));
+            // the clock is only read every few tasks, the timer checks later
+            if (tasks.size() >= limit ||
+                ((tasks.size() & 7U) == 0 &&
+                 std::chrono::steady_clock::now() - buffer.firstAdded[lane] >=
+                     std::chrono::nanoseconds(batchDelayLimit.load(
+                         std::memory_order_relaxed)))) {
+                full.swap(tasks);
             }
         }
-        if (numWorkers > 0) {
-            switch (priority) {
-                case WorkPriority::high:
-                case WorkPriority::required:
-                    workToDoHigh.pushVector(newWork);
-                    break;
-                case WorkPriority::medium:
-                    workToDoMed.pushVector(newWork);
-                    break;
-                case WorkPriority::low:
-                default:
-                    workToDoLow.pushVector(newWork);
-                    break;
+        if (started) {
+            ++pendingBatches;
+        }
+        if (!full.empty()) {
+            --pendingBatches;
+            submitBatch(lane, std::move(full));
+        } else if (started) {
+            // sleeping workers are left alone so the batch can fill up
+            armBatchTimer();
+        }
+    }
+    /** queue the tasks buffered by addBatchedTask on all threads*/
+    void flushBatches() { flushBuffers(false); }
+    /** get the number of threads with a batch buffer on the queue
+@details the buffer of a thread that has exited is released by the next flush
+*/
+    std::size_t numBatchBuffers()
+    {
+        std::lock_guard<std::mutex> guard(batchLock);
+        return batchBuffers.size();
+    }
+    /** set when the tasks buffered by addBatchedTask are queued
+@param[in] count the number of tasks in a full block, at least 1
+@param[in] delay the longest time a task is buffered while more tasks are
+added*/
+    void setBatchLimits(std::size_t count, std::chrono::nanoseconds delay)
+    {
+        batchCountLimit.store(std::max<std::size_t>(count, 1));
+        batchDelayLimit.store(delay.count());
+    }
+    /** counts of the work added with a deadline*/
+    struct DeadlineCounters {
+        std::uint64_t completed{0};  //!< deadline work that has completed
+        std::uint64_t missed{0};  //!< work completed after its deadline
+        std::uint64_t lateStarts{0};  //!< work started after its deadline
+    };
+    /** add work that should be completed by a deadline
+@details deadline work is kept in an earliest deadline first lane, once the
+high priority lane is empty the workers take the work with the earliest
+deadline before any medium or low priority work.  Work with equal deadlines
+runs in the order it was added.  Work completing after its deadline is counted
+as a miss, see getDeadlineCounters.
+@param[in] deadline the time the work should be completed by
+@param[in] work a work block or a nullary callable
+*/
+    template<typename Work>
+    void addDeadlineWork(
+        std::chrono::steady_clock::time_point deadline,
+        Work&& work)
+    {
+        if constexpr (std::is_convertible_v<
+                          Work,
+                          std::shared_ptr<BasicWorkBlock>>) {
+            std::shared_ptr<BasicWorkBlock> block(std::forward<Work>(work));
+            if (!block || block->isFinished()) {
+                return;
             }
-            queueCondition.notify_all();
+            addDeadlineTask(
+                deadline,
+                WorkTask([this, deadline, block = std::move(block)]() {
+                    if (!block->isFinished()) {
+                        runDeadlineWork(deadline, [&block]() {
+                            block->execute();
+                        });
+                    }
+                }));
         } else {
-            for (auto& wb : newWork) {
-                wb->execute();
+            addDeadlineTask(
+                deadline,
+                WorkTask([this,
+                          deadline,
+                          func = std::forward<Work>(work)]() mutable {
+                    runDeadlineWork(deadline, func);
+                }));
+        }
+    }
+    /** get the counts of completed and missed deadline work*/
+    DeadlineCounters getDeadlineCounters() const
+    {
+        DeadlineCounters counters;
+        counters.completed = deadlineCompleted.load();
+        counters.missed = deadlineMissed.load();
+        counters.lateStarts = deadlineLateStarts.load();
+        return counters;
+    }
+    /** get the number of tasks that ended with an exception
+@details tasks added with addTask, addBatchedTask, delayed and periodic
+callables and deadline callables have no future to carry an exception, so it
+is dropped and counted here instead of ending the worker thread*/
+    std::uint64_t getTaskErrorCount() const { return taskErrors.load(); }
+    /** add work to the queue after a delay
+@details the timers are kept in a hierarchical timing wheel with a 1 ms tick
+serviced by a single timer thread, started with the first timer, so pending
+timers do not occupy any worker
+@param[in] delay the time to wait before the work is queued
+@param[in] work a work block or a nullary callable
+@param[in] priority the priority the work is queued with
+@return a handle that can be passed to cancelTimer
+*/
+    template<typename Work>
+    TimerHandle addDelayedWork(
+        std::chrono::steady_clock::duration delay,
+        Work&& work,
+        WorkPriority priority = WorkPriority::medium)
+    {
+        TimerEntry entry;
+        entry.task = WorkTask(std::forward<Work>(work));
+        entry.priority = priority;
+        return addTimer(delay, std::move(entry), {});
+    }
+    /** queue work repeatedly with a fixed period
+@details the first run is one period from now, if the previous run has not
+finished when the period expires that run is skipped.  A run that throws is
+counted by getTaskErrorCount and does not stop the later runs.
+@param[in] period the time between runs
+@param[in] task a nullary callable, it is called once per period until the
+timer is cancelled or the queue is closed
+@param[in] priority the priority the work is queued with
+@return a handle that can be passed to cancelTimer
+*/
+    template<typename Func>
+    TimerHandle addPeriodicWork(
+        std::chrono::steady_clock::duration period,
+        Func&& task,
+        WorkPriority priority = WorkPriority::medium)
+    {
+        static_assert(
+            !std::is_convertible_v<Func, std::shared_ptr<BasicWorkBlock>>,
+            "a work block only runs once, periodic work requires a callable");
+        TimerEntry entry;
+        entry.periodic = std::make_shared<PeriodicWork>();
+        entry.periodic->task = WorkTask(std::forward<Func>(task));
+        entry.priority = priority;
+        return addTimer(period, std::move(entry), period);
+    }
+    /** cancel delayed or periodic work
+@return true if the timer was pending, false if the delayed work has already
+been queued or the handle is not valid*/
+    bool cancelTimer(const TimerHandle& handle)
+    {
+        std::lock_guard<std::mutex> timerGuard(timerLock);
+        return timers.cancel(handle);
+    }
+    /** get the number of pending delayed and periodic work items*/
+    std::size_t getTimerCount() const
+    {
+        std::lock_guard<std::mutex> timerGuard(timerLock);
+        return timers.size();
+    }
+    /** schedule work to run once a work block has completed
+@details the continuation is added to this queue by the thread completing the
+predecessor so no worker waits for the result.  The function is called with
+the result of the predecessor, or with no arguments if it returns void.  An
+exception thrown by the predecessor is forwarded to the future of the
+continuation.  If the queue has been closed or destroyed by the time the
+predecessor completes the continuation is cancelled and its future reports
+WorkCancelled.
+@param[in] predecessor the work block that must complete first
+@param[in] func the function to run with the result
+@param[in] priority the priority of the continuation
+@return a shared pointer to the work block of the continuation
+*/
+    template<typename T, typename Func>
+    auto then(
+        const std::shared_ptr<WorkBlock<T>>& predecessor,
+        Func&& func,
+        WorkPriority priority = WorkPriority::medium)
+    {
+        auto step = [result = predecessor->get_future(),
+                     func = std::forward<Func>(func)]() mutable {
+            if constexpr (std::is_void_v<T>) {
+                result.get();
+                return func();
+            } else {
+                return func(result.get());
+            }
+        };
+        auto next = make_shared_workBlock(std::move(step));
+        predecessor->onCompletion([link = queueLink, next, priority]() {
+            if (!link->add(WorkTask(next), priority)) {
+                next->cancel();
             }
+        });
+        return next;
+    }
+    /** awaitable that moves a coroutine onto the workers of a queue*/
+    class ScheduleAwaiter {
+      public:
+        ScheduleAwaiter(WorkQueue& workQueue, WorkPriority workPriority) :
+            queue(workQueue), priority(workPriority)
+        {
+        }
+        bool await_ready() const noexcept { return false; }
+        /** queue the resumption of the coroutine
+@return false to continue on the calling thread if the queue is closed*/
+        bool await_suspend(std::coroutine_handle<> awaiting)
+        {
+            return queue.addTaskInternal(
+                WorkTask([awaiting]() { awaiting.resume(); }), priority);
+        }
+        void await_resume() const noexcept {}
+
+      private:
+        WorkQueue& queue;
+        WorkPriority priority;
+    };
+    /** awaitable that resumes a coroutine on a queue once a block completes*/
+    template<typename T>
+    class BlockAwaiter {
+      public:
+        BlockAwaiter(
+            WorkQueue& workQueue,
+            std::shared_ptr<WorkBlock<T>> workBlock,
+            WorkPriority workPriority) :
+            queue(workQueue), block(std::move(workBlock)),
+            priority(workPriority)
+        {
+        }
+        bool await_ready() const
+        {
+            return block->get_future().wait_for(std::chrono::seconds(0)) ==
+                std::future_status::ready;
         }
+        void await_suspend(std::coroutine_handle<> awaiting)
+        {
+            block->onCompletion([link = queue.queueLink,
+                                 awaiting,
+                                 workPriority = priority]() {
+                if (!link->add(
+                        WorkTask([awaiting]() { awaiting.resume(); }),
+                        workPriority)) {
+                    awaiting.resume();
+                }
+            });
+        }
+        /** get the result of the block, rethrows its exception*/
+        T await_resume() { return block->get_future().get(); }
+
+      private:
+        WorkQueue& queue;
+        std::shared_ptr<WorkBlock<T>> block;
+        WorkPriority priority;
+    };
+    /** move the calling coroutine onto the workers
+@details use as co_await queue.schedule(), the coroutine continues on a
+worker once the resumption is taken from the given priority lane.  If the
+queue has no workers it continues immediately, and if the queue is closed it
+continues on the calling thread.
+@param[in] priority the priority the resumption is queued with
+*/
+    ScheduleAwaiter schedule(WorkPriority priority = WorkPriority::medium)
+    {
+        return {*this, priority};
+    }
+    /** wait for a work block from a coroutine without blocking a thread
+@details use as co_await queue.after(block), the coroutine is suspended until
+the block completes and then resumed on the workers, the value of the
+expression is the result of the block
+@param[in] block the work block to wait for
+@param[in] priority the priority the resumption is queued with
+*/
+    template<typename T>
+    BlockAwaiter<T> after(
+        std::shared_ptr<WorkBlock<T>> block,
+        WorkPriority priority = WorkPriority::medium)
+    {
+        return {*this, std::move(block), priority};
+    }
+    /** call a function for every position of a range using the workers
+@details the range is split recursively in halves, one half is offered to the
+workers while the calling thread continues with the other and takes back any
+half no worker has started.  Halves picked up by a worker may be split again,
+so the partitioning adapts to the number of idle workers.  The call returns
+once the whole range is done, and the first exception thrown is rethrown.
+@param[in] begin the start of the range, an integer or a random access
+iterator
+@param[in] end the end of the range
+@param[in] grain the size below which a range is not split further
+@param[in] func called with each index for an integer range or with a
+reference to each element for an iterator range
+@param[in] priority the priority the pieces offered to the workers are queued
+with
+*/
+    template<typename Iter, typename Func>
+    void parallel_for(
+        Iter begin,
+        Iter end,
+        std::size_t grain,
+        Func&& func,
+        WorkPriority priority = WorkPriority::medium)
+    {
+        auto chunk = [&func](Iter first, Iter last, bool /*unused*/) {
+            for (; first != last; ++first) {
+                func(rangeValue(first));
+            }
+            return true;
+        };
+        auto combine = [](bool /*left*/, bool /*right*/) { return true; };
+        parallelRange(begin, end, grain, true, chunk, combine, priority);
+    }
+    /** reduce a range to a single value using the workers
+@details the range is partitioned as in parallel_for.  Each chunk is reduced
+starting from identity and the chunk results are combined in range order, so
+the operations need to be associative but not commutative.
+@param[in] begin the start of the range, an integer or a random access
+iterator
+@param[in] end the end of the range
+@param[in] grain the size below which a range is not split further
+@param[in] identity the initial value of every chunk
+@param[in] reduce called as reduce(T, value) for each index or element
+@param[in] combine called as combine(T, T) to merge chunk results
+@param[in] priority the priority the pieces offered to the workers are queued
+with
+@return the reduced value
+*/
+    template<typename Iter, typename T, typename Reduce, typename Combine>
+    T parallel_reduce(
+        Iter begin,
+        Iter end,
+        std::size_t grain,
+        const T& identity,
+        Reduce&& reduce,
+        Combine&& combine,
+        WorkPriority priority = WorkPriority::medium)
+    {
+        auto chunk = [&reduce](Iter first, Iter last, T value) {
+            for (; first != last; ++first) {
+                value = reduce(std::move(value), rangeValue(first));
+            }
+            return value;
+        };
+        return parallelRange(
+            begin, end, grain, identity, chunk, combine, priority);
+    }
+    /** reduce a range with a single operation used to accumulate values and
+to combine chunk results, for example std::plus<>*/
+    template<typename Iter, typename T, typename Reduce>
+    T parallel_reduce(
+        Iter begin,
+        Iter end,
+        std::size_t grain,
+        const T& identity,
+        Reduce&& reduce,
+        WorkPriority priority = WorkPriority::medium)
+    {
+        return parallel_reduce(
+            begin, end, grain, identity, reduce, reduce, priority);
     }
     /** check if the queue is empty
 @details this function may not be that useful since it is multithreaded and
@@ -442,8 +2123,23 @@ the answer is not necessarily valid after it returns
 */
     bool isEmpty() const
     {
-        return (
-            workToDoHigh.empty() && workToDoMed.empty() && workToDoLow.empty());
+        if (!(workToDoHigh.empty() && workToDoMed.empty() &&
+              workToDoLow.empty() && deadlineCount.load() == 0)) {
+            return false;
+        }
+        for (const auto& local : localWork) {
+            if (local->count.load() > 0) {
+                return false;
+            }
+        }
+        for (const auto& node : nodeWork) {
+            for (const auto& lane : node->lanes) {
+                if (!lane.empty()) {
+                    return false;
+                }
+            }
+        }
+        return true;
     };
     /** get the number of remaining blocks
  @details this function may not be that useful since it is multithreaded and
@@ -451,7 +2147,17 @@ the answer is not necessarily valid after it returns
 */
     size_t numBlock() const
     {
-        return (workToDoHigh.size() + workToDoMed.size() + workToDoLow.size());
+        size_t count = workToDoHigh.size() + workToDoMed.size() +
+            workToDoLow.size() + deadlineCount.load();
+        for (const auto& local : localWork) {
+            count += local->count.load();
+        }
+        for (const auto& node : nodeWork) {
+            for (const auto& lane : node->lanes) {
+                count += lane.size();
+            }
+        }
+        return count;
     };
     /** set the ratio of medium block executions to low priority block
 executions
@@ -463,65 +2169,1281 @@ default value*/
             (newPriorityRatio > 0) ? newPriorityRatio : defaultPriorityRatio;
     };
     /** get the next work block
+@details tasks added through addTask are wrapped in a new work block
 @return a shared pointer to a work block
 */
     std::shared_ptr<BasicWorkBlock> getWorkBlock()
     {
-        std::shared_ptr<BasicWorkBlock> wb;
-        auto wbb = workToDoHigh.pop();
-        if (wbb) {
-            return *wbb;
+        auto task = getTask();
+        if (!task) {
+            return nullptr;
+        }
+        auto wb = task.getBlock();
+        if (wb) {
+            return wb;
+        }
+        return std::make_shared<WorkBlock<void>>(
+            [task = std::move(task)]() mutable { task(); });
+    }
+    /** get the next task
+@return the task, which will be empty if there is no work available
+*/
+    WorkTask getTask()
+    {
+        auto task = nextTask();
+        if (task && minWorkers != maxWorkers) {
+            --queuedTasks;
+        }
+        recordDequeue(task);
+        return task;
+    }
+
+  private:
+    /** take the next task in priority order*/
+    WorkTask nextTask()
+    {
+        const int self = currentWorkerIndex();
+        auto task = takeFromLane(highLane, self);
+        if (task) {
+            --highQueued;
+            return task;
+        }
+        if (self >= 0 && self < reservedWorkers) {
+            return task;
+        }
+        if (deadlineCount.load() > 0) {
+            task = takeDeadlineTask();
+            if (task) {
+                return task;
+            }
         }
 
         if (MedCounter >= priorityRatio) {
-            if (!workToDoLow.empty()) {
-                wbb = workToDoLow.pop();
-                if (wbb) {
-                    MedCounter = 0;
-                    return *wbb;
-                }
+            task = takeFromLane(lowLane, self);
+            if (task) {
+                MedCounter = 0;
+                return task;
             }
         }
-        wbb = workToDoMed.pop();
-        if (wbb) {
+        task = takeFromLane(medLane, self);
+        if (task) {
             ++MedCounter;
-            return *wbb;
+            return task;
         }
-        wbb = workToDoLow.pop();
-        if (wbb) {
-            return *wbb;
+        return takeFromLane(lowLane, self);
+    }
+
+    /** metrics slot of the deadline lane, after those of the priorities*/
+    static constexpr std::size_t deadlineSlot{4};
+    /** indices of the priority lanes*/
+    static constexpr std::size_t highLane{0};
+    static constexpr std::size_t medLane{1};
+    static constexpr std::size_t lowLane{2};
+
+    /** queues for the work submitted from one NUMA node*/
+    struct NodeWorkQueues {
+        std::array<SimpleQueue<WorkTask>, 3>
+            lanes;  //!< high, medium, and low priority work
+    };
+    /** per worker deques used by the work stealing scheduler
+@details the owning worker pushes and pops at the back and thieves take from
+the front of each lane.  The elements are move only tasks which cannot be
+published through atomic slots, so each deque has a small lock instead of the
+lock-free Chase-Lev protocol; it is only contended while a steal is in progress
+*/
+    struct LocalWorkDeque {
+        std::mutex lock;  //!< lock protecting the lanes
+        std::array<StableBlockDeque<WorkTask, 6>, 3>
+            lanes;  //!< high, medium, and low priority work
+        std::atomic<std::size_t> count{0};  //!< total blocks in the lanes
+    };
+
+    /** reference to the queue held by continuations, which may run after the
+queue is destroyed
+@details the destructor of the queue detaches the link, waiting for any add in
+progress, after which adds through the link fail*/
+    class QueueLink {
+      public:
+        explicit QueueLink(WorkQueue* workQueue) : queue(workQueue) {}
+        /** add a task to the queue if it still accepts work
+@return false if the queue is closed or destroyed*/
+        bool add(WorkTask&& task, WorkPriority priority)
+        {
+            WorkQueue* target{nullptr};
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (queue == nullptr) {
+                    return false;
+                }
+                target = queue;
+                ++users;
+            }
+            bool added{false};
+            try {
+                added = target->addTaskInternal(std::move(task), priority);
+            }
+            catch (...) {
+                release();
+                throw;
+            }
+            release();
+            return added;
+        }
+        /** stop adds to the queue and wait for those in progress*/
+        void detach()
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            queue = nullptr;
+            released.wait(guard, [this] { return users == 0; });
+        }
+
+      private:
+        void release()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (--users == 0) {
+                released.notify_all();
+            }
         }
+        std::mutex lock;  //!< lock protecting the queue pointer
+        std::condition_variable released;  //!< signals the last add ended
+        WorkQueue* queue;  //!< the queue, nullptr once detached
+        int users{0};  //!< the number of adds in progress
+    };
 
+    /** identification of the WorkQueue worker running on a thread*/
+    struct WorkerIdentity {
+        const WorkQueue* queue{nullptr};  //!< the queue owning the worker
+        int index{-1};  //!< the index of the worker in the queue
+        std::uint32_t rngState{1};  //!< state for randomized victim selection
+        int node{-1};  //!< the NUMA node index of the worker or -1
+    };
+    /** get the worker identity of the current thread*/
+    static WorkerIdentity& currentWorker()
+    {
+        static thread_local WorkerIdentity identity;
+        return identity;
+    }
+    /** get the index of the current thread if it is a worker of this queue
+@return the worker index or -1 if the thread is not one of the workers*/
+    int currentWorkerIndex() const
+    {
+        const auto& identity = currentWorker();
+        return (identity.queue == this) ? identity.index : -1;
+    }
+
+    /** map a priority to the index of a lane*/
+    static constexpr std::size_t laneIndex(WorkPriority priority)
+    {
+        switch (priority) {
+            case WorkPriority::high:
+            case WorkPriority::required:
+                return highLane;
+            case WorkPriority::medium:
+                return medLane;
+            case WorkPriority::low:
+            default:
+                return lowLane;
+        }
+    }
+
+    /** get the shared queue for a lane*/
+    SimpleQueue<WorkTask>& sharedLane(std::size_t lane)
+    {
+        return (lane == highLane) ? workToDoHigh :
+            (lane == medLane)     ? workToDoMed :
+                                    workToDoLow;
+    }
+
+    /** get the queue for work submitted from the current thread
+@details with NUMA local submission this is the queue of the node the thread
+is running on, otherwise the shared queue*/
+    SimpleQueue<WorkTask>& submitLane(std::size_t lane)
+    {
+        if (!nodeWork.empty()) {
+            const int self = currentWorkerIndex();
+            const int node = (self >= 0) ?
+                currentWorker().node :
+                detail::CpuTopology::instance().nodeOf(detail::currentCpu());
+            if (node >= 0 && node < static_cast<int>(nodeWork.size())) {
+                return nodeWork[node]->lanes[lane];
+            }
+        }
+        return sharedLane(lane);
+    }
+
+    /** compute the cpus and NUMA node of each worker*/
+    void placeWorkers(const WorkerAffinity& affinity)
+    {
+        using Placement = WorkerAffinity::Placement;
+        if (affinity.placement == Placement::none) {
+            return;
+        }
+        if (affinity.placement == Placement::cpuSet &&
+            !detail::pinnableCpus(affinity.cpus)) {
+            throw(std::invalid_argument("cpu set contains no valid cpu"));
+        }
+        const auto& topology = detail::CpuTopology::instance();
+        workerCpus.resize(maxWorkers);
+        workerNodes.assign(maxWorkers, -1);
+        for (int kk = 0; kk < maxWorkers; ++kk) {
+            switch (affinity.placement) {
+                case Placement::cpuSet:
+                    workerCpus[kk] = affinity.cpus;
+                    break;
+                case Placement::perCore:
+                    if (!topology.cores.empty()) {
+                        workerCpus[kk] =
+                            topology.cores[kk % topology.cores.size()];
+                    }
+                    break;
+                case Placement::perNumaNode:
+                default:
+                    workerCpus[kk] = topology.nodes[kk % topology.nodes.size()];
+                    break;
+            }
+            if (!workerCpus[kk].empty()) {
+                workerNodes[kk] = topology.nodeOf(workerCpus[kk].front());
+            }
+        }
+        if (affinity.numaLocalSubmission && topology.nodes.size() > 1) {
+            nodeWork.reserve(topology.nodes.size());
+            for (std::size_t ii = 0; ii < topology.nodes.size(); ++ii) {
+                nodeWork.push_back(std::make_unique<NodeWorkQueues>());
+            }
+        }
+    }
+
+    /** get a block from a priority lane
+@details checks the worker's own deque, then the shared queue, then tries to
+steal from the other workers starting at a random victim
+@param lane the index of the priority lane
+@param self the index of the calling worker or -1 if not a worker
+*/
+    WorkTask takeFromLane(std::size_t lane, int self)
+    {
+        WorkTask wb;
+        if (self >= 0 && !localWork.empty()) {
+            auto& local = *localWork[self];
+            if (local.count.load() > 0) {
+                std::lock_guard<std::mutex> localLock(local.lock);
+                auto& work = local.lanes[lane];
+                if (!work.empty()) {
+                    wb = std::move(work.back());
+                    work.pop_back();
+                    --local.count;
+                    return wb;
+                }
+            }
+        }
+        const int node =
+            (self >= 0 && !nodeWork.empty()) ? currentWorker().node : -1;
+        if (node >= 0) {
+            auto nodeTask = nodeWork[node]->lanes[lane].pop();
+            if (nodeTask) {
+                return std::move(*nodeTask);
+            }
+        }
+        auto wbb = sharedLane(lane).pop();
+        if (wbb) {
+            return std::move(*wbb);
+        }
+        for (std::size_t ii = 0; ii < nodeWork.size(); ++ii) {
+            if (static_cast<int>(ii) == node) {
+                continue;
+            }
+            auto nodeTask = nodeWork[ii]->lanes[lane].pop();
+            if (nodeTask) {
+                return std::move(*nodeTask);
+            }
+        }
+        if (localWork.empty()) {
+            return wb;
+        }
+        const auto workerCount = static_cast<std::uint32_t>(localWork.size());
+        auto& rng = currentWorker().rngState;
+        // xorshift32 to pick the first victim
+        rng ^= rng << 13U;
+        rng ^= rng >> 17U;
+        rng ^= rng << 5U;
+        const std::uint32_t start = rng % workerCount;
+        for (std::uint32_t ii = 0; ii < workerCount; ++ii) {
+            const auto victim = (start + ii) % workerCount;
+            if (static_cast<int>(victim) == self) {
+                continue;
+            }
+            auto& local = *localWork[victim];
+            if (local.count.load() == 0) {
+                continue;
+            }
+            std::lock_guard<std::mutex> localLock(local.lock);
+            auto& work = local.lanes[lane];
+            if (!work.empty()) {
+                wb = std::move(work.front());
+                work.pop_front();
+                --local.count;
+                return wb;
+            }
+        }
         return wb;
     }
 
-  private:
+    /** the value passed to the function for a position in a range*/
+    template<typename Iter>
+    static decltype(auto) rangeValue(Iter& position)
+    {
+        if constexpr (std::is_integral_v<Iter>) {
+            return static_cast<Iter>(position);
+        } else {
+            return *position;
+        }
+    }
+    /** the number of positions in a range*/
+    template<typename Iter>
+    static std::size_t rangeSize(const Iter& first, const Iter& last)
+    {
+        return (last > first) ? static_cast<std::size_t>(last - first) : 0U;
+    }
+    /** a position a number of steps into a range*/
+    template<typename Iter>
+    static Iter rangeAdvance(const Iter& first, std::size_t steps)
+    {
+        if constexpr (std::is_integral_v<Iter>) {
+            return static_cast<Iter>(first + static_cast<Iter>(steps));
+        } else {
+            using difference =
+                typename std::iterator_traits<Iter>::difference_type;
+            return first + static_cast<difference>(steps);
+        }
+    }
+
+    /** state shared by the pieces of one parallel_for or parallel_reduce*/
+    template<
+        typename Iter,
+        typename T,
+        typename ChunkFunc,
+        typename CombineFunc>
+    struct ParallelContext {
+        /** half of a range offered to the workers*/
+        struct Piece {
+            Piece(Iter start, Iter stop, ParallelContext* owner) :
+                first(start), last(stop), context(owner)
+            {
+            }
+            Iter first;
+            Iter last;
+            ParallelContext* context;  //!< only used once the piece is claimed
+            std::atomic<int> state{pieceQueued};
+            std::optional<T> result;
+            std::exception_ptr error;
+        };
+        static constexpr int pieceQueued{0};
+        static constexpr int pieceClaimed{1};
+        static constexpr int pieceDone{2};
+
+        WorkQueue& queue;
+        std::size_t grain;
+        const T& identity;
+        ChunkFunc& chunk;
+        CombineFunc& combine;
+        int stealDepth;  //!< extra splits allowed for a piece run by a worker
+        WorkPriority priority;  //!< the priority the pieces are queued with
+
+        /** process a range splitting it at most depth more times*/
+        T run(Iter first, Iter last, int depth)
+        {
+            const auto count = rangeSize(first, last);
+            if (count <= grain || depth <= 0) {
+                return chunk(first, last, identity);
+            }
+            const auto middle = rangeAdvance(first, count / 2);
+            auto right = std::make_shared<Piece>(middle, last, this);
+            queue.addTask(
+                [right, depth]() { execute(*right, depth - 1); }, priority);
+            std::optional<T> left;
+            std::exception_ptr error;
+            try {
+                left.emplace(run(first, middle, depth - 1));
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            int expected{pieceQueued};
+            if (right->state.compare_exchange_strong(expected, pieceClaimed)) {
+                if (!error) {
+                    try {
+                        right->result.emplace(
+                            run(right->first, right->last, depth - 1));
+                    }
+                    catch (...) {
+                        error = std::current_exception();
+                    }
+                }
+            } else {
+                right->state.wait(pieceClaimed);
+                if (!error) {
+                    error = right->error;
+                }
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return combine(std::move(*left), std::move(*right->result));
+        }
+        /** run a piece on a worker unless the caller has taken it back*/
+        static void execute(Piece& piece, int depth)
+        {
+            int expected{pieceQueued};
+            if (!piece.state.compare_exchange_strong(expected, pieceClaimed)) {
+                return;
+            }
+            auto* context = piece.context;
+            try {
+                piece.result.emplace(context->run(
+                    piece.first,
+                    piece.last,
+                    std::max(depth, context->stealDepth)));
+            }
+            catch (...) {
+                piece.error = std::current_exception();
+            }
+            piece.state.store(pieceDone);
+            piece.state.notify_all();
+        }
+    };
+
+    /** split a range over the workers and the calling thread*/
+    template<
+        typename Iter,
+        typename T,
+        typename ChunkFunc,
+        typename CombineFunc>
+    T parallelRange(
+        Iter begin,
+        Iter end,
+        std::size_t grain,
+        const T& identity,
+        ChunkFunc& chunk,
+        CombineFunc& combine,
+        WorkPriority priority)
+    {
+        grain = std::max(grain, std::size_t{1});
+        if (maxWorkers == 0 || rangeSize(begin, end) <= grain) {
+            return chunk(begin, end, identity);
+        }
+        // enough splits for a few pieces per thread
+        int depth{2};
+        for (int threads = std::max(activeWorkers.load(), 1) + 1; threads > 1;
+             threads /= 2) {
+            ++depth;
+        }
+        ParallelContext<Iter, T, ChunkFunc, CombineFunc> context{
+            *this, grain, identity, chunk, combine, 2, priority};
+        return context.run(begin, end, depth);
+    }
+
+    /** add a task to the appropriate queue and wake a worker, or run it if
+there are no workers
+@return false if the queue is closed and the task was dropped*/
+    bool addTaskInternal(WorkTask&& task, WorkPriority priority)
+    {
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            if (halt.load()) {
+                return false;
+            }
+        }
+        markQueued(task, priority);
+        if (maxWorkers > 0) {
+            countQueued(1);
+            const int self = currentWorkerIndex();
+            if (self >= 0 && !localWork.empty()) {
+                auto& local = *localWork[self];
+                {
+                    std::lock_guard<std::mutex> localLock(local.lock);
+                    local.lanes[laneIndex(priority)].push_back(
+                        std::move(task));
+                    ++local.count;
+                }
+                wakeReserved(priority, 1);
+                checkWorkerGrowth();
+                wakeWorkers(1);
+                return true;
+            }
+            submitLane(laneIndex(priority)).push(std::move(task));
+            wakeReserved(priority, 1);
+            checkWorkerGrowth();
+            wakeWorkers(1);
+        } else {
+            runTask(task);
+        }
+        return true;
+    }
+
+    /** work in the earliest deadline first lane*/
+    struct DeadlineEntry {
+        std::chrono::steady_clock::time_point deadline;
+        std::uint64_t sequence;  //!< keeps equal deadlines in order
+        WorkTask task;
+    };
+    /** heap comparison putting the earliest deadline at the front*/
+    static bool
+        laterDeadline(const DeadlineEntry& lhs, const DeadlineEntry& rhs)
+    {
+        return (lhs.deadline != rhs.deadline) ? lhs.deadline > rhs.deadline :
+                                                lhs.sequence > rhs.sequence;
+    }
+    /** add a task to the deadline lane or run it if there are no workers*/
+    void addDeadlineTask(
+        std::chrono::steady_clock::time_point deadline,
+        WorkTask&& task)
+    {
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            if (halt.load()) {
+                return;
+            }
+        }
+        markQueued(task, deadlineSlot);
+        if (maxWorkers > 0) {
+            countQueued(1);
+            {
+                std::lock_guard<std::mutex> deadlineGuard(deadlineLock);
+                deadlineWork.push_back(DeadlineEntry{
+                    deadline, deadlineSequence++, std::move(task)});
+                std::push_heap(
+                    deadlineWork.begin(), deadlineWork.end(), laterDeadline);
+                ++deadlineCount;
+            }
+            checkWorkerGrowth();
+            wakeWorkers(1);
+        } else {
+            runTask(task);
+        }
+    }
+    /** take the work with the earliest deadline
+@return the task or an empty task if the lane is empty*/
+    WorkTask takeDeadlineTask()
+    {
+        std::lock_guard<std::mutex> deadlineGuard(deadlineLock);
+        if (deadlineWork.empty()) {
+            return {};
+        }
+        std::pop_heap(deadlineWork.begin(), deadlineWork.end(), laterDeadline);
+        auto task = std::move(deadlineWork.back().task);
+        deadlineWork.pop_back();
+        --deadlineCount;
+        return task;
+    }
+    /** run deadline work and count late starts and misses*/
+    template<typename Func>
+    void runDeadlineWork(
+        std::chrono::steady_clock::time_point deadline,
+        Func&& func)
+    {
+        if (std::chrono::steady_clock::now() > deadline) {
+            ++deadlineLateStarts;
+        }
+        func();
+        if (std::chrono::steady_clock::now() > deadline) {
+            ++deadlineMissed;
+        }
+        ++deadlineCompleted;
+    }
+
+    /** tasks buffered by addBatchedTask on one thread*/
+    struct BatchBuffer {
+        std::thread::id owner;  //!< the thread adding the tasks
+        std::mutex lock;  //!< lock protecting the buffers
+        std::array<std::vector<WorkTask>, 3>
+            lanes;  //!< high, medium, and low priority tasks
+        std::array<std::chrono::steady_clock::time_point, 3>
+            firstAdded;  //!< time the first buffered task of a lane was added
+        std::atomic<bool> orphaned{false};  //!< set once the owner has exited
+    };
+    /** the batch buffers a thread holds on any queue
+@details the buffers are shared with the queues so marking them on thread exit
+is safe after a queue is gone, the queue releases a marked buffer on its next
+flush*/
+    struct BatchBufferCache {
+        std::uint64_t queueId{0};  //!< the queue of the last buffer used
+        BatchBuffer* buffer{nullptr};  //!< the last buffer used
+        /** the buffers of the thread*/
+        std::vector<std::shared_ptr<BatchBuffer>> owned;
+        BatchBufferCache() = default;
+        BatchBufferCache(const BatchBufferCache&) = delete;
+        BatchBufferCache& operator=(const BatchBufferCache&) = delete;
+        ~BatchBufferCache()
+        {
+            for (auto& held : owned) {
+                held->orphaned.store(true, std::memory_order_release);
+            }
+        }
+    };
+    /** get an identifier unique to each WorkQueue object*/
+    static std::uint64_t nextQueueId()
+    {
+        static std::atomic<std::uint64_t> counter{0};
+        return ++counter;
+    }
+    /** get the batch buffer of the calling thread*/
+    BatchBuffer& batchBuffer()
+    {
+        // the buffer of the last queue the thread used, identified by id
+        // since a later queue may reuse the address
+        static thread_local BatchBufferCache cache;
+        if (cache.queueId == queueId) {
+            return *cache.buffer;
+        }
+        const auto self = std::this_thread::get_id();
+        std::lock_guard<std::mutex> guard(batchLock);
+        BatchBuffer* found{nullptr};
+        for (auto& buffer : batchBuffers) {
+            // an exited thread may have had the same id
+            if (buffer->owner == self && !buffer->orphaned.load()) {
+                found = buffer.get();
+                break;
+            }
+        }
+        if (found == nullptr) {
+            // drop the buffers of queues that are gone
+            std::erase_if(cache.owned, [](const auto& buffer) {
+                return buffer.use_count() == 1;
+            });
+            auto buffer = std::make_shared<BatchBuffer>();
+            buffer->owner = self;
+            found = buffer.get();
+            cache.owned.push_back(buffer);
+            batchBuffers.push_back(std::move(buffer));
+        }
+        cache.queueId = queueId;
+        cache.buffer = found;
+        return *found;
+    }
+    /** queue buffered tasks and release the buffers of exited threads
+@param[in] expiredOnly set to queue only the lanes older than the delay*/
+    void flushBuffers(bool expiredOnly)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const std::chrono::nanoseconds delay(
+            batchDelayLimit.load(std::memory_order_relaxed));
+        std::vector<std::pair<std::size_t, std::vector<WorkTask>>> batches;
+        {
+            std::lock_guard<std::mutex> guard(batchLock);
+            auto buffer = batchBuffers.begin();
+            while (buffer != batchBuffers.end()) {
+                // read before the lanes so the owner added its last task
+                const bool exited =
+                    (*buffer)->orphaned.load(std::memory_order_acquire);
+                {
+                    std::lock_guard<std::mutex> bufferGuard((*buffer)->lock);
+                    for (std::size_t lane = 0; lane < (*buffer)->lanes.size();
+                         ++lane) {
+                        auto& tasks = (*buffer)->lanes[lane];
+                        if (!tasks.empty() &&
+                            (exited || !expiredOnly ||
+                             now - (*buffer)->firstAdded[lane] >= delay)) {
+                            batches.emplace_back(lane, std::move(tasks));
+                            tasks.clear();
+                            --pendingBatches;
+                        }
+                    }
+                }
+                buffer = exited ? batchBuffers.erase(buffer) : buffer + 1;
+            }
+        }
+        for (auto& batch : batches) {
+            submitBatch(batch.first, std::move(batch.second));
+        }
+    }
+    /** have the timer thread queue the batches older than the delay*/
+    void armBatchTimer()
+    {
+        if (!batchTimerArmed.exchange(true)) {
+            TimerEntry entry;
+            entry.batchFlush = true;
+            addTimer(
+                std::chrono::nanoseconds(
+                    batchDelayLimit.load(std::memory_order_relaxed)),
+                std::move(entry),
+                {});
+        }
+    }
+    /** queue the buffered tasks of a lane as one task*/
+    void submitBatch(std::size_t lane, std::vector<WorkTask>&& tasks)
+    {
+        const auto priority = (lane == highLane) ? WorkPriority::high :
+            (lane == medLane)                    ? WorkPriority::medium :
+                                                   WorkPriority::low;
+        addTaskInternal(
+            WorkTask([this, batch = std::move(tasks)]() mutable {
+                for (auto& task : batch) {
+                    runTask(task);
+                }
+            }),
+            priority);
+    }
+
+    /** add a batch of tasks to a lane with a single lock*/
+    void addTaskBatch(std::vector<WorkTask>&& tasks, WorkPriority priority)
+    {
+        if (tasks.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            if (halt.load()) {
+                return;
+            }
+        }
+        if (maxWorkers > 0) {
+            const auto count = tasks.size();
+            for (auto& task : tasks) {
+                markQueued(task, priority);
+            }
+            countQueued(count);
+            const int self = currentWorkerIndex();
+            if (self >= 0 && !localWork.empty()) {
+                auto& local = *localWork[self];
+                std::lock_guard<std::mutex> localLock(local.lock);
+                auto& lane = local.lanes[laneIndex(priority)];
+                for (auto& task : tasks) {
+                    lane.push_back(std::move(task));
+                }
+                local.count += count;
+            } else {
+                submitLane(laneIndex(priority)).pushVector(std::move(tasks));
+            }
+            wakeReserved(priority, count);
+            checkWorkerGrowth();
+            wakeWorkers(count);
+        } else {
+            for (auto& task : tasks) {
+                runTask(task);
+            }
+        }
+    }
+
+    /** start a worker thread in a free slot, poolLock must be held*/
+    void startWorker(int index)
+    {
+        if (threadpool[index].joinable()) {
+            // a retired worker that has finished or is about to
+            threadpool[index].join();
+        }
+        workerRunning[index] = true;
+        ++activeWorkers;
+        threadpool[index] = std::thread([this, index] {
+            std::unique_ptr<detail::TaskArena> arena;
+            if (scalingLimits.taskArenaSize > 0) {
+                arena = std::make_unique<detail::TaskArena>(
+                    scalingLimits.taskArenaSize);
+            }
+            detail::currentTaskArena() = arena.get();
+            recordWorkerStart(index);
+            workerLoop(index);
+            recordWorkerExit(index);
+            detail::currentTaskArena() = nullptr;
+        });
+    }
+    /** count queued tasks for the growth check of an elastic queue*/
+    void countQueued(std::size_t count)
+    {
+        if (minWorkers != maxWorkers) {
+            queuedTasks += static_cast<std::int64_t>(count);
+        }
+    }
+    /** start another worker if the queued work is not being picked up*/
+    void checkWorkerGrowth()
+    {
+        if (minWorkers == maxWorkers || sleepers.load() > 0 ||
+            activeWorkers.load() >= maxWorkers) {
+            return;
+        }
+        const int active = activeWorkers.load();
+        bool grow = (active == 0);
+        if (!grow) {
+            grow = queuedTasks.load() >
+                static_cast<std::int64_t>(
+                    scalingLimits.queueDepthThreshold *
+                    static_cast<std::size_t>(active));
+        }
+        if (!grow) {
+            const std::chrono::steady_clock::duration waited(
+                std::chrono::steady_clock::now().time_since_epoch().count() -
+                lastProgress.load());
+            grow = waited > scalingLimits.waitThreshold;
+        }
+        if (!grow) {
+            return;
+        }
+        std::lock_guard<std::mutex> poolGuard(poolLock);
+        if (halt.load() || activeWorkers.load() >= maxWorkers ||
+            threadpool.empty()) {
+            return;
+        }
+        for (int kk = 0; kk < maxWorkers; ++kk) {
+            if (!workerRunning[kk]) {
+                // give the new worker a fresh window before growing again
+                lastProgress.store(std::chrono::steady_clock::now()
+                                       .time_since_epoch()
+                                       .count());
+                startWorker(kk);
+                return;
+            }
+        }
+    }
+    /** remove an idle worker if the queue is above its minimum size
+@details called with queueLock held
+@return true if the worker should exit*/
+    bool retireWorker(int index)
+    {
+        if (halt.load() ||
+            (!localWork.empty() && localWork[index]->count.load() > 0)) {
+            return false;
+        }
+        int active = activeWorkers.load();
+        while (active > minWorkers) {
+            if (activeWorkers.compare_exchange_weak(active, active - 1)) {
+                std::lock_guard<std::mutex> poolGuard(poolLock);
+                workerRunning[index] = false;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** runner for a work block submitted with a cancellation token*/
+    struct GroupBlockRunner {
+        std::shared_ptr<BasicWorkBlock> block;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+        void operator()() const
+        {
+            if (cancelled->load(std::memory_order_acquire)) {
+                block->cancel();
+            } else if (!block->isFinished()) {
+                block->execute();
+            }
+        }
+    };
+    /** work scheduled periodically*/
+    struct PeriodicWork {
+        WorkTask task;  //!< the work to run every period
+        std::atomic<bool> running{false};  //!< set while a run is queued
+    };
+    /** value stored in the timer wheel*/
+    struct TimerEntry {
+        WorkTask task;  //!< the delayed work
+        std::shared_ptr<PeriodicWork> periodic;  //!< set for periodic work
+        WorkPriority priority{WorkPriority::medium};
+        bool batchFlush{false};  //!< set for the timer flushing old batches
+    };
+    /** insert a timer and make sure the timer thread sees it*/
+    TimerHandle addTimer(
+        std::chrono::steady_clock::duration delay,
+        TimerEntry&& entry,
+        std::chrono::steady_clock::duration period)
+    {
+        std::lock_guard<std::mutex> timerGuard(timerLock);
+        if (halt.load() || timerHalt) {
+            return {};
+        }
+        if (!timerThread.joinable()) {
+            timerThread = std::thread(&WorkQueue::timerLoop, this);
+        }
+        const auto expiry = std::chrono::steady_clock::now() + delay;
+        auto handle = timers.insert(expiry, std::move(entry), period);
+        if (expiry < timerWakeTime) {
+            timerCondition.notify_one();
+        }
+        return handle;
+    }
+    /** the loop run by the timer thread*/
+    void timerLoop()
+    {
+        std::vector<std::pair<WorkTask, WorkPriority>> due;
+        bool flushDue{false};
+        std::unique_lock<std::mutex> timerGuard(timerLock);
+        while (!timerHalt) {
+            timers.advance(
+                std::chrono::steady_clock::now(),
+                [&due, &flushDue](TimerEntry& entry) {
+                    if (entry.batchFlush) {
+                        flushDue = true;
+                    } else if (!entry.periodic) {
+                        due.emplace_back(
+                            std::move(entry.task), entry.priority);
+                    } else if (!entry.periodic->running.exchange(true)) {
+                        due.emplace_back(
+                            WorkTask([periodic = entry.periodic]() {
+                                try {
+                                    periodic->task();
+                                }
+                                catch (...) {
+                                    // counted by the queue running the task
+                                    periodic->running.store(false);
+                                    throw;
+                                }
+                                periodic->running.store(false);
+                            }),
+                            entry.priority);
+                    }
+                });
+            if (!due.empty() || flushDue) {
+                timerGuard.unlock();
+                for (auto& [task, priority] : due) {
+                    addTaskInternal(std::move(task), priority);
+                }
+                due.clear();
+                if (flushDue) {
+                    flushDue = false;
+                    batchTimerArmed.store(false);
+                    flushBuffers(true);
+                    if (pendingBatches.load() > 0) {
+                        armBatchTimer();
+                    }
+                }
+                timerGuard.lock();
+                continue;
+            }
+            const auto next = timers.nextEventTime();
+            timerWakeTime =
+                next ? *next : std::chrono::steady_clock::time_point::max();
+            if (next) {
+                timerCondition.wait_until(timerGuard, *next);
+            } else {
+                timerCondition.wait(timerGuard);
+            }
+            timerWakeTime = std::chrono::steady_clock::time_point::min();
+        }
+    }
+    /** stop the timer thread and drop the pending timers*/
+    void stopTimers()
+    {
+        {
+            std::lock_guard<std::mutex> timerGuard(timerLock);
+            timerHalt = true;
+            timers.clear();
+            timerCondition.notify_all();
+        }
+        if (timerThread.joinable()) {
+            timerThread.join();
+        }
+    }
+
+    /** wake sleeping workers after work was added
+@details the sleeper count is read after the work is published and a worker
+increments it under queueLock before its final emptiness check, so either the
+worker sees the new work or this call sees the sleeper; taking queueLock before
+notifying ensures the notification cannot land before the worker waits
+@param count the maximum number of workers to wake
+*/
+    void wakeWorkers(std::size_t count)
+    {
+        const auto sleeping = static_cast<std::size_t>(sleepers.load());
+        if (sleeping == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lv(queueLock);
+            if (sleepers.load() > 0) {
+                if (count >= sleeping) {
+                    queueCondition.notify_all();
+                } else {
+                    for (std::size_t ii = 0; ii < count; ++ii) {
+                        queueCondition.notify_one();
+                    }
+                }
+                return;
+            }
+        }
+        // the sleepers seen earlier woke up or retired in the meantime
+        checkWorkerGrowth();
+    }
+
+    /** count high priority work and wake the reserved workers for it*/
+    void wakeReserved(WorkPriority priority, std::size_t count)
+    {
+        if (laneIndex(priority) != highLane) {
+            return;
+        }
+        highQueued += static_cast<std::int64_t>(count);
+        if (reservedSleepers.load() > 0) {
+            std::lock_guard<std::mutex> lv(queueLock);
+            if (count > 1) {
+                reservedCondition.notify_all();
+            } else {
+                reservedCondition.notify_one();
+            }
+        }
+    }
+
     /** the main worker loop*/
-    void workerLoop()
+    void workerLoop(int index)
     {
+        auto& identity = currentWorker();
+        identity.queue = this;
+        identity.index = index;
+        identity.rngState =
+            static_cast<std::uint32_t>(index) * 2654435761U + 1U;
+        if (!workerCpus.empty()) {
+            detail::pinCurrentThread(workerCpus[index]);
+            identity.node = workerNodes[index];
+        }
+        auto& helper = detail::waitHelper();
+        helper.runOne = &WorkQueue::runQueuedTask;
+        helper.context = this;
+        const bool reserved = (index < reservedWorkers);
         while (true) {
-            if (isEmpty()) {
+            if (reserved && highQueued.load() <= 0) {
+                workerIdle(index);
                 std::unique_lock<std::mutex> lv(queueLock);
                 if (halt.load()) {
                     return;
                 }
-                queueCondition.wait_for(lv, std::chrono::milliseconds(5000));
+                ++reservedSleepers;
+                reservedCondition.wait(
+                    lv, [this] { return halt || highQueued.load() > 0; });
+                --reservedSleepers;
+                if (halt) {
+                    return;
+                }
+            } else if (!reserved && isEmpty()) {
+                if (pendingBatches.load() > 0) {
+                    // out of work, so queue the tasks buffered on other threads
+                    flushBatches();
+                    continue;
+                }
+                workerIdle(index);
+                std::unique_lock<std::mutex> lv(queueLock);
+                if (halt.load()) {
+                    return;
+                }
+                ++sleepers;
+                if (minWorkers < maxWorkers) {
+                    if (!queueCondition.wait_for(
+                            lv, scalingLimits.idleTimeout, [this] {
+                                return halt || !isEmpty() ||
+                                    pendingBatches.load() > 0;
+                            }) &&
+                        retireWorker(index)) {
+                        --sleepers;
+                        return;
+                    }
+                } else {
+                    queueCondition.wait(lv, [this] {
+                        return halt || !isEmpty() || pendingBatches.load() > 0;
+                    });
+                }
+                --sleepers;
                 if (halt) {
                     return;
                 }
             }
-            auto wb =
-                getWorkBlock();  // this will return empty if it is spurious
-                                 // and also sync the size if needed
-            if ((wb) && (!wb->isFinished())) {
-                wb->execute();
+            auto task =
+                getTask();  // this will return empty if it is spurious
+                            // and also sync the size if needed
+            if (task) {
+                if (minWorkers < maxWorkers) {
+                    lastProgress.store(std::chrono::steady_clock::now()
+                                           .time_since_epoch()
+                                           .count());
+                }
+                executeTask(task, index);
             }
         }
     }
 
+    /** run one queued task on a worker waiting for a work block
+@return false if there was no task to run*/
+    static bool runQueuedTask(void* context)
+    {
+        auto* queue = static_cast<WorkQueue*>(context);
+        auto task = queue->getTask();
+        if (!task && queue->pendingBatches.load() > 0) {
+            queue->flushBatches();
+            task = queue->getTask();
+        }
+        if (!task) {
+            return false;
+        }
+        queue->executeTask(task, queue->currentWorkerIndex());
+        return true;
+    }
+
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS
+    /** metric counters of a worker, the last set is shared by other threads*/
+    struct alignas(64) MetricCounters {
+        std::array<detail::AtomicHistogram, deadlineSlot + 1> queueWait;
+        std::array<detail::AtomicHistogram, deadlineSlot + 1> execution;
+        std::atomic<std::int64_t> busy{0};  //!< nanoseconds spent executing
+        std::atomic<std::int64_t> startedAt{0};  //!< start time or 0
+    };
+#endif
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS || GMLC_CONTAINERS_WORKQUEUE_TRACING
+    /** get the current time in nanoseconds*/
+    static std::int64_t metricClock()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+#endif
+    /** stamp a task with the time and priority it is queued with*/
+    void markQueued(WorkTask& task, WorkPriority priority) const
+    {
+        markQueued(task, static_cast<std::size_t>(priority));
+    }
+    /** stamp a task with the time and metrics slot it is queued with
+@details with only the tracing compiled in a task queued while the recording
+is off is left unstamped and is not recorded*/
+    void markQueued(WorkTask& task, std::size_t slot) const
+    {
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS
+        task.queuedAt = metricClock();
+        task.queuedPriority = slot;
+#elif GMLC_CONTAINERS_WORKQUEUE_TRACING
+        task.queuedAt = tracingActive.load(std::memory_order_relaxed) ?
+            metricClock() :
+            0;
+        task.queuedPriority = slot;
+#else
+        (void)task;
+        (void)slot;
+#endif
+    }
+    /** record the time a task spent in the queue*/
+    void recordDequeue(const WorkTask& task)
+    {
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS
+        if (task) {
+            const int self = currentWorkerIndex();
+            metricCounters[(self >= 0) ? self : maxWorkers]
+                .queueWait[task.queuedPriority]
+                .record(metricClock() - task.queuedAt);
+        }
+#else
+        (void)task;
+#endif
+    }
+    /** execute a task on a worker and record the execution time*/
+    void executeTask(WorkTask& task, int index)
+    {
+        const detail::TaskArenaScope arenaScope;
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS || GMLC_CONTAINERS_WORKQUEUE_TRACING
+#    if !GMLC_CONTAINERS_WORKQUEUE_METRICS
+        if (task.queuedAt == 0) {
+            // queued while the recording was off, the clock is not read
+            traceBuffers[index].lastEnd = 0;
+            runTask(task);
+            return;
+        }
+#    endif
+        const auto start = taskStartTime(index, task.queuedAt);
+        runTask(task);
+        const auto end = metricClock();
+        taskEnded(index, end);
+#    if GMLC_CONTAINERS_WORKQUEUE_METRICS
+        auto& counters = metricCounters[index];
+        counters.execution[task.queuedPriority].record(end - start);
+        counters.busy.fetch_add(end - start, std::memory_order_relaxed);
+#    endif
+#    if GMLC_CONTAINERS_WORKQUEUE_TRACING
+        if (tracingActive.load(std::memory_order_relaxed)) {
+            traceBuffers[index].record(
+                {task.queuedAt, start, end, task.queuedPriority});
+        }
+#    endif
+#else
+        (void)index;
+        runTask(task);
+#endif
+    }
+    /** run a task, dropping and counting an exception it throws*/
+    void runTask(WorkTask& task) noexcept
+    {
+        try {
+            task();
+        }
+        catch (...) {
+            ++taskErrors;
+        }
+    }
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS || GMLC_CONTAINERS_WORKQUEUE_TRACING
+    /** get the time a task starts on a worker
+@details with only the tracing compiled in, the end of the previous task is
+used while the worker stays busy and the task was queued before it, which saves
+a clock read per task at the cost of counting taking the task from the queue as
+part of it
+@param[in] index the worker running the task
+@param[in] queuedAt the time the task was queued*/
+    std::int64_t taskStartTime(int index, std::int64_t queuedAt)
+    {
+#    if GMLC_CONTAINERS_WORKQUEUE_TRACING
+        auto& trace = traceBuffers[index];
+        ++trace.nesting;
+#        if !GMLC_CONTAINERS_WORKQUEUE_METRICS
+        if (trace.nesting == 1 && trace.lastEnd >= queuedAt &&
+            trace.lastEnd != 0) {
+            return trace.lastEnd;
+        }
+#        else
+        (void)queuedAt;
+#        endif
+#    else
+        (void)index;
+        (void)queuedAt;
+#    endif
+        return metricClock();
+    }
+    /** note the end of a task on a worker*/
+    void taskEnded(int index, std::int64_t end)
+    {
+#    if GMLC_CONTAINERS_WORKQUEUE_TRACING
+        auto& trace = traceBuffers[index];
+        // a wait may have run between the nested task and the rest of this one
+        trace.lastEnd = (--trace.nesting == 0) ? end : 0;
+#    else
+        (void)index;
+        (void)end;
+#    endif
+    }
+#endif
+    /** note that a worker is about to wait for work*/
+    void workerIdle(int index)
+    {
+#if GMLC_CONTAINERS_WORKQUEUE_TRACING
+        traceBuffers[index].lastEnd = 0;
+#else
+        (void)index;
+#endif
+    }
+    /** record the start of a worker thread*/
+    void recordWorkerStart(int index)
+    {
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS
+        metricCounters[index].startedAt.store(metricClock());
+#else
+        (void)index;
+#endif
+    }
+    /** add the running time of an exiting worker to the total*/
+    void recordWorkerExit(int index)
+    {
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS
+        const auto started = metricCounters[index].startedAt.exchange(0);
+        retiredWorkerTime += metricClock() - started;
+#else
+        (void)index;
+#endif
+    }
+
   private:
     WorkQueue(WorkQueue const&) = delete;
     WorkQueue& operator=(WorkQueue const&) = delete;
+    /** strands run their tasks through runTask*/
+    template<typename Key, typename Hash>
+    friend class StrandExecutor;
 
     std::atomic<int> priorityRatio{defaultPriorityRatio};  //!< the ratio of
                                                            //!< medium
@@ -530,19 +3452,80 @@ default value*/
                                                            //!< low
     //!< priority blocks
 
-    SimpleQueue<std::shared_ptr<BasicWorkBlock>>
-        workToDoHigh;  //!< queue containing the work to do
-    SimpleQueue<std::shared_ptr<BasicWorkBlock>>
-        workToDoMed;  //!< queue containing the work to do
-    SimpleQueue<std::shared_ptr<BasicWorkBlock>>
-        workToDoLow;  //!< queue containing the work to do
-    const int numWorkers;  //!< counter for the number of workers
+    SimpleQueue<WorkTask> workToDoHigh;  //!< queue containing the work to do
+    SimpleQueue<WorkTask> workToDoMed;  //!< queue containing the work to do
+    SimpleQueue<WorkTask> workToDoLow;  //!< queue containing the work to do
+    std::mutex deadlineLock;  //!< lock protecting the deadline lane
+    std::vector<DeadlineEntry> deadlineWork;  //!< heap of deadline work
+    std::uint64_t deadlineSequence{0};  //!< counter ordering equal deadlines
+    std::atomic<std::size_t> deadlineCount{0};  //!< work in the deadline lane
+    std::atomic<std::uint64_t> deadlineCompleted{0};  //!< completed deadlines
+    std::atomic<std::uint64_t> deadlineMissed{0};  //!< missed deadlines
+    std::atomic<std::uint64_t> deadlineLateStarts{0};  //!< late starts
+    std::atomic<std::uint64_t> taskErrors{0};  //!< tasks that threw
+    const int minWorkers;  //!< the number of workers always running
+    const int maxWorkers;  //!< the largest number of workers
+    const int reservedWorkers;  //!< workers only taking high priority work
+    const SchedulingMode schedulingMode;  //!< how work is distributed
+    std::vector<std::unique_ptr<NodeWorkQueues>>
+        nodeWork;  //!< per node queues, empty unless NUMA local submission
+    std::vector<std::vector<int>> workerCpus;  //!< cpus of each worker
+    std::vector<int> workerNodes;  //!< NUMA node index of each worker
+    std::vector<std::unique_ptr<LocalWorkDeque>>
+        localWork;  //!< per worker deques for the work stealing mode
     std::atomic<int> MedCounter{0};  //!< the counter to use low instead of Med
+    const WorkerScaling scalingLimits;  //!< thresholds for elastic workers
     std::vector<std::thread> threadpool;  //!< the threads
+    std::vector<bool> workerRunning;  //!< slots with a running worker
+    std::mutex poolLock;  //!< lock protecting the threads and slots
+    std::atomic<int> activeWorkers{0};  //!< the number of running workers
+    /** steady clock ticks when a worker last took work*/
+    std::atomic<std::chrono::steady_clock::rep> lastProgress{0};
     std::mutex queueLock;  //!< mutex for condition variable and halt
     std::condition_variable queueCondition;  //!< condition variable for
                                              //!< waking the threads
+    std::atomic<int> sleepers{0};  //!< number of workers waiting for work
+    /** condition variable for waking the reserved workers*/
+    std::condition_variable reservedCondition;
+    std::atomic<int> reservedSleepers{0};  //!< reserved workers waiting
+    /** high and required priority work queued, may briefly be negative*/
+    std::atomic<std::int64_t> highQueued{0};
+    /** tasks queued on an elastic queue, may briefly be negative*/
+    std::atomic<std::int64_t> queuedTasks{0};
+    const std::uint64_t queueId{nextQueueId()};  //!< identifies the queue
+    std::mutex batchLock;  //!< lock protecting the list of batch buffers
+    /** the buffers of the threads that used addBatchedTask*/
+    std::vector<std::shared_ptr<BatchBuffer>> batchBuffers;
+    /** buffer lanes holding tasks, may briefly be negative*/
+    std::atomic<int> pendingBatches{0};
+    /** set while the timer flushing old batches is pending*/
+    std::atomic<bool> batchTimerArmed{false};
+    std::atomic<std::size_t> batchCountLimit{64};  //!< tasks in a full block
+    /** nanoseconds a task is buffered while more tasks are added*/
+    std::atomic<std::int64_t> batchDelayLimit{100000};
     std::atomic<bool> halt{false};  //!< flag indicating the threads should halt
+    /** the link to this queue held by continuations*/
+    std::shared_ptr<QueueLink> queueLink{std::make_shared<QueueLink>(this)};
+    mutable std::mutex timerLock;  //!< lock protecting the timer state
+    std::condition_variable timerCondition;  //!< wakes the timer thread
+    TimerWheel<TimerEntry> timers;  //!< pending delayed and periodic work
+    std::thread timerThread;  //!< thread servicing the timers
+    /** the time the timer thread sleeps until*/
+    std::chrono::steady_clock::time_point timerWakeTime{
+        std::chrono::steady_clock::time_point::min()};
+    bool timerHalt{false};  //!< flag indicating the timer thread should stop
+#if GMLC_CONTAINERS_WORKQUEUE_METRICS
+    /** metric counters of each worker and one set for other threads*/
+    std::unique_ptr<MetricCounters[]> metricCounters;
+    /** nanoseconds workers that have exited were running*/
+    std::atomic<std::int64_t> retiredWorkerTime{0};
+#endif
+#if GMLC_CONTAINERS_WORKQUEUE_TRACING
+    /** the executions recorded by each worker*/
+    std::unique_ptr<detail::TraceBuffer[]> traceBuffers;
+    const std::int64_t traceOrigin{metricClock()};  //!< time 0 of the trace
+    std::atomic<bool> tracingActive{true};  //!< set while recording the trace
+#endif
 };
 
 }  // namespace gmlc::containers
@@ -0,0 +1,267 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved.
+
+SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#    include <pthread.h>
+#    include <sched.h>
+#endif
+
+namespace gmlc::containers {
+/** description of how the worker threads of a WorkQueue are placed on the
+processors
+@details placement uses pthread_setaffinity_np and the sysfs topology so it is
+only available on Linux, on other platforms the workers are left unpinned.
+Placement is best effort, cpus outside the affinity mask of the process are
+ignored.
+*/
+struct WorkerAffinity {
+    /** the ways the workers can be placed*/
+    enum class Placement {
+        none,  //!< the workers are not pinned
+        cpuSet,  //!< every worker may run on any cpu of a given set
+        perCore,  //!< each worker is pinned to one physical core in turn
+        perNumaNode,  //!< the workers are spread over the NUMA nodes in turn
+                      //!< and may run on any cpu of their node
+    };
+    Placement placement{Placement::none};  //!< the placement of the workers
+    std::vector<int> cpus;  //!< the cpus used for Placement::cpuSet
+    /** queue work submitted from a known NUMA node for the workers of that
+node, other workers only take it once their own node has no work*/
+    bool numaLocalSubmission{false};
+
+    /** pin all workers to a set of cpus*/
+    static WorkerAffinity cpuSet(std::vector<int> cpuList)
+    {
+        WorkerAffinity affinity;
+        affinity.placement = Placement::cpuSet;
+        affinity.cpus = std::move(cpuList);
+        return affinity;
+    }
+    /** pin one worker per physical core*/
+    static WorkerAffinity perCore(bool localSubmission = false)
+    {
+        WorkerAffinity affinity;
+        affinity.placement = Placement::perCore;
+        affinity.numaLocalSubmission = localSubmission;
+        return affinity;
+    }
+    /** spread the workers over the NUMA nodes*/
+    static WorkerAffinity perNumaNode(bool localSubmission = true)
+    {
+        WorkerAffinity affinity;
+        affinity.placement = Placement::perNumaNode;
+        affinity.numaLocalSubmission = localSubmission;
+        return affinity;
+    }
+};
+
+namespace detail {
+    /** parse a cpu list in the sysfs format such as "0-3,8,10-11"*/
+    inline std::vector<int> parseCpuList(const std::string& text)
+    {
+        std::vector<int> cpus;
+        std::size_t position{0};
+        while (position < text.size()) {
+            auto next = text.find(',', position);
+            if (next == std::string::npos) {
+                next = text.size();
+            }
+            const auto item = text.substr(position, next - position);
+            position = next + 1;
+            const auto dash = item.find('-');
+            try {
+                const int first = std::stoi(item.substr(0, dash));
+                const int last = (dash == std::string::npos) ?
+                    first :
+                    std::stoi(item.substr(dash + 1));
+                for (int cpu = first; cpu <= last; ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            }
+            catch (const std::exception&) {
+                // skip malformed or empty entries
+            }
+        }
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        return cpus;
+    }
+
+    /** read a cpu list file
+@return the cpus or an empty vector if the file is not available*/
+    inline std::vector<int> readCpuList(const std::string& path)
+    {
+        std::ifstream file(path);
+        std::string text;
+        if (!file || !std::getline(file, text)) {
+            return {};
+        }
+        return parseCpuList(text);
+    }
+
+    /** the processor topology available to the process*/
+    struct CpuTopology {
+        std::vector<int> cpus;  //!< the usable cpus
+        std::vector<std::vector<int>> cores;  //!< the cpus of each core
+        std::vector<std::vector<int>> nodes;  //!< the cpus of each node
+        std::vector<int> cpuNode;  //!< node index of each cpu or -1
+
+        /** get the node index of a cpu or -1 if it is not known*/
+        int nodeOf(int cpu) const
+        {
+            return (cpu >= 0 && cpu < static_cast<int>(cpuNode.size())) ?
+                cpuNode[cpu] :
+                -1;
+        }
+        /** get the topology of the machine, read once from sysfs*/
+        static const CpuTopology& instance()
+        {
+            static const CpuTopology topology = read();
+            return topology;
+        }
+
+      private:
+        static CpuTopology read()
+        {
+            const std::string root{"/sys/devices/system/"};
+            CpuTopology topology;
+            topology.cpus = allowedCpus(readCpuList(root + "cpu/online"));
+            auto usable = [&topology](std::vector<int> list) {
+                list.erase(
+                    std::remove_if(
+                        list.begin(),
+                        list.end(),
+                        [&topology](int cpu) {
+                            return !std::binary_search(
+                                topology.cpus.begin(),
+                                topology.cpus.end(),
+                                cpu);
+                        }),
+                    list.end());
+                return list;
+            };
+            for (auto cpu : topology.cpus) {
+                auto siblings = usable(readCpuList(
+                    root + "cpu/cpu" + std::to_string(cpu) +
+                    "/topology/thread_siblings_list"));
+                if (siblings.empty()) {
+                    siblings.push_back(cpu);
+                }
+                if (std::find(
+                        topology.cores.begin(),
+                        topology.cores.end(),
+                        siblings) == topology.cores.end()) {
+                    topology.cores.push_back(std::move(siblings));
+                }
+            }
+            for (auto node : readCpuList(root + "node/online")) {
+                auto nodeCpus = usable(readCpuList(
+                    root + "node/node" + std::to_string(node) + "/cpulist"));
+                if (!nodeCpus.empty()) {
+                    topology.nodes.push_back(std::move(nodeCpus));
+                }
+            }
+            if (topology.nodes.empty()) {
+                topology.nodes.push_back(topology.cpus);
+            }
+            const int maxCpu =
+                topology.cpus.empty() ? -1 : topology.cpus.back();
+            topology.cpuNode.assign(static_cast<std::size_t>(maxCpu + 1), -1);
+            for (std::size_t node = 0; node < topology.nodes.size(); ++node) {
+                for (auto cpu : topology.nodes[node]) {
+                    topology.cpuNode[cpu] = static_cast<int>(node);
+                }
+            }
+            return topology;
+        }
+        /** restrict a list of cpus to the affinity mask of the process*/
+        static std::vector<int> allowedCpus(std::vector<int> online)
+        {
+            if (online.empty()) {
+                const auto count =
+                    std::max(std::thread::hardware_concurrency(), 1U);
+                for (unsigned int cpu = 0; cpu < count; ++cpu) {
+                    online.push_back(static_cast<int>(cpu));
+                }
+            }
+#if defined(__linux__)
+            cpu_set_t mask;
+            CPU_ZERO(&mask);
+            if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+                online.erase(
+                    std::remove_if(
+                        online.begin(),
+                        online.end(),
+                        [&mask](int cpu) {
+                            return cpu >= CPU_SETSIZE ||
+                                CPU_ISSET(cpu, &mask) == 0;
+                        }),
+                    online.end());
+            }
+#endif
+            return online;
+        }
+    };
+
+    /** check if a set of cpus contains any cpu a thread can be pinned to*/
+    inline bool pinnableCpus(const std::vector<int>& cpus)
+    {
+        return std::any_of(cpus.begin(), cpus.end(), [](int cpu) {
+#if defined(__linux__)
+            return cpu >= 0 && cpu < CPU_SETSIZE;
+#else
+            return cpu >= 0;
+#endif
+        });
+    }
+
+    /** pin the calling thread to a set of cpus
+@return true if the affinity was set*/
+    inline bool pinCurrentThread(const std::vector<int>& cpus)
+    {
+#if defined(__linux__)
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        bool any{false};
+        for (auto cpu : cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &mask);
+                any = true;
+            }
+        }
+        return any &&
+            pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+#else
+        (void)cpus;
+        return false;
+#endif
+    }
+
+    /** get the cpu the calling thread is running on or -1 if unknown*/
+    inline int currentCpu()
+    {
+#if defined(__linux__)
+        return sched_getcpu();
+#else
+        return -1;
+#endif
+    }
+}  // namespace detail
+}  // namespace gmlc::containers
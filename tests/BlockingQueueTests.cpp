@@ -107,6 +107,39 @@ TEST(blocking_queue, emplace)
     EXPECT_EQ(popped_value->second, 34.1);
 }
 
+TEST(blocking_queue, remove_if)
+{
+    BlockingQueue<std::pair<int, int>> queue;
+    for (int index = 0; index < 20; ++index) {
+        queue.emplace(index % 4, index);
+    }
+    // move part of the queue into the pull side
+    auto popped_value = queue.try_pop();
+    EXPECT_EQ(popped_value->second, 0);
+    for (int index = 20; index < 30; ++index) {
+        queue.emplace(index % 4, index);
+    }
+    auto removed = queue.remove_if(
+        [](const std::pair<int, int>& element) { return element.first == 1; });
+    EXPECT_EQ(removed, 8U);
+    EXPECT_EQ(queue.size(), 21U);
+    int previous{0};
+    popped_value = queue.try_pop();
+    while (popped_value) {
+        EXPECT_NE(popped_value->first, 1);
+        EXPECT_GT(popped_value->second, previous);
+        previous = popped_value->second;
+        popped_value = queue.try_pop();
+    }
+    EXPECT_EQ(previous, 28);
+
+    queue.emplace(1, 1);
+    removed = queue.remove_if(
+        [](const std::pair<int, int>& element) { return element.first == 1; });
+    EXPECT_EQ(removed, 1U);
+    EXPECT_TRUE(queue.empty());
+}
+
 /** test with single consumer/single producer*/
 TEST(blocking_queue, multithreaded)
 {
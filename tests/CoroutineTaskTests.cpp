@@ -0,0 +1,155 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "CoroutineTask.hpp"
+
+#include "gtest/gtest.h"
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using gmlc::containers::CoroutineTask;
+using gmlc::containers::make_shared_workBlock;
+using gmlc::containers::WorkQueue;
+
+namespace {
+CoroutineTask<std::thread::id> threadOf(WorkQueue& queue)
+{
+    co_await queue.schedule();
+    co_return std::this_thread::get_id();
+}
+
+CoroutineTask<int> square(WorkQueue& queue, int value)
+{
+    co_await queue.schedule(WorkQueue::WorkPriority::high);
+    co_return value * value;
+}
+
+CoroutineTask<int> sumOfSquares(WorkQueue& queue, int count)
+{
+    int sum{0};
+    for (int ii = 1; ii <= count; ++ii) {
+        sum += co_await square(queue, ii);
+    }
+    co_return sum;
+}
+
+CoroutineTask<> failing(WorkQueue& queue)
+{
+    co_await queue.schedule();
+    throw(std::runtime_error("coroutine failed"));
+}
+}  // namespace
+
+TEST(coroutineTask, schedule)
+{
+    WorkQueue work_queue(1);
+    auto task = threadOf(work_queue);
+    EXPECT_FALSE(task.isDone());
+    EXPECT_NE(task.get(), std::this_thread::get_id());
+    EXPECT_TRUE(task.isDone());
+}
+
+TEST(coroutineTask, chain)
+{
+    WorkQueue work_queue(2);
+    EXPECT_EQ(sumOfSquares(work_queue, 10).get(), 385);
+}
+
+TEST(coroutineTask, inline_queue)
+{
+    // without workers the coroutine continues on the calling thread
+    WorkQueue work_queue(0);
+    EXPECT_EQ(threadOf(work_queue).get(), std::this_thread::get_id());
+    EXPECT_EQ(sumOfSquares(work_queue, 3).get(), 14);
+}
+
+TEST(coroutineTask, exception)
+{
+    WorkQueue work_queue(1);
+    EXPECT_THROW(failing(work_queue).get(), std::runtime_error);
+
+    auto caught = [](WorkQueue& queue) -> CoroutineTask<std::string> {
+        try {
+            co_await failing(queue);
+        }
+        catch (const std::runtime_error& error) {
+            co_return std::string(error.what());
+        }
+        co_return std::string();
+    };
+    EXPECT_EQ(caught(work_queue).get(), "coroutine failed");
+}
+
+TEST(coroutineTask, await_block)
+{
+    // the only worker waits for a block queued behind the coroutine, which
+    // would deadlock with WorkBlock::wait()
+    WorkQueue work_queue(1);
+    auto pipeline = [](WorkQueue& queue) -> CoroutineTask<int> {
+        co_await queue.schedule();
+        auto block = make_shared_workBlock([] { return 20; });
+        queue.addWorkBlock(block, WorkQueue::WorkPriority::low);
+        const int first = co_await queue.after(block);
+        // a block that has already completed does not suspend
+        const int second = co_await queue.after(block);
+        co_return first + second + 2;
+    };
+    EXPECT_EQ(pipeline(work_queue).get(), 42);
+
+    auto cancelled = [](WorkQueue& queue) -> CoroutineTask<bool> {
+        auto block = make_shared_workBlock([] {});
+        block->cancel();
+        try {
+            co_await queue.after(block);
+        }
+        catch (const gmlc::containers::WorkCancelled&) {
+            co_return true;
+        }
+        co_return false;
+    };
+    EXPECT_TRUE(cancelled(work_queue).get());
+}
+
+TEST(coroutineTask, many)
+{
+    WorkQueue work_queue(2);
+    std::atomic<int> count{0};
+    auto worker = [](WorkQueue& queue,
+                     std::atomic<int>& counter) -> CoroutineTask<> {
+        for (int ii = 0; ii < 10; ++ii) {
+            co_await queue.schedule(
+                (ii % 2 == 0) ? WorkQueue::WorkPriority::medium :
+                                WorkQueue::WorkPriority::low);
+            ++counter;
+        }
+    };
+    auto all = [&worker](
+                   WorkQueue& queue,
+                   std::atomic<int>& counter) -> CoroutineTask<> {
+        std::vector<CoroutineTask<>> tasks;
+        for (int ii = 0; ii < 200; ++ii) {
+            tasks.push_back(worker(queue, counter));
+        }
+        for (auto& task : tasks) {
+            co_await task;
+        }
+    };
+    all(work_queue, count).get();
+    EXPECT_EQ(count.load(), 2000);
+}
+
+TEST(coroutineTask, closed_queue)
+{
+    WorkQueue work_queue(1);
+    work_queue.closeWorkerQueue();
+    // a closed queue leaves the coroutine on the calling thread
+    EXPECT_EQ(threadOf(work_queue).get(), std::this_thread::get_id());
+}
@@ -14,6 +14,7 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 #include <random>
 #include <thread>
 #include <utility>
+#include <vector>
 /** these test cases test data_block and data_view objects
  */
 
@@ -51,6 +52,74 @@ TEST(blocking_priority_queue, basic_tests)
     EXPECT_EQ(*popped_value, 45);
 }
 
+/** test the fairness ratio between the priority channel and normal lane*/
+TEST(blocking_priority_queue, priority_ratio)
+{
+    BlockingPriorityQueue<int> queue;
+    queue.setPriorityRatio(3);
+    for (int index = 0; index < 4; ++index) {
+        queue.push(index);
+    }
+    for (int index = 0; index < 7; ++index) {
+        queue.pushPriority(100 + index);
+    }
+    const std::vector<int> expected{
+        100, 101, 102, 0, 103, 104, 105, 1, 106, 2, 3};
+    std::vector<int> order;
+    auto popped_value = queue.try_pop();
+    while (popped_value) {
+        order.push_back(*popped_value);
+        popped_value = queue.try_pop();
+    }
+    EXPECT_EQ(order, expected);
+    EXPECT_EQ(queue.getFairnessCount(), 2U);
+
+    // strict priority is restored with a ratio of 0
+    queue.setPriorityRatio(0);
+    queue.push(1);
+    for (int index = 0; index < 5; ++index) {
+        queue.pushPriority(index + 10);
+    }
+    for (int index = 0; index < 5; ++index) {
+        EXPECT_EQ(queue.pop(), index + 10);
+    }
+    EXPECT_EQ(queue.pop(), 1);
+    EXPECT_EQ(queue.getFairnessCount(), 2U);
+}
+
+/** test the fairness settings are carried through a move and clear*/
+TEST(blocking_priority_queue, priority_ratio_move)
+{
+    BlockingPriorityQueue<int> queue;
+    queue.setPriorityRatio(2);
+    queue.push(1);
+    queue.pushPriority(10);
+    queue.pushPriority(11);
+    queue.pushPriority(12);
+    EXPECT_EQ(*queue.try_pop(), 10);
+
+    BlockingPriorityQueue<int> moved(std::move(queue));
+    EXPECT_EQ(*moved.try_pop(), 11);
+    EXPECT_EQ(*moved.try_pop(), 1);
+    EXPECT_EQ(*moved.try_pop(), 12);
+    EXPECT_EQ(moved.getFairnessCount(), 1U);
+
+    BlockingPriorityQueue<int> assigned;
+    assigned = std::move(moved);
+    EXPECT_EQ(assigned.getFairnessCount(), 1U);
+    assigned.clear();
+    // the streak starts over after a clear
+    assigned.pushPriority(22);
+    EXPECT_EQ(*assigned.try_pop(), 22);
+    assigned.push(2);
+    assigned.pushPriority(23);
+    assigned.pushPriority(24);
+    EXPECT_EQ(*assigned.try_pop(), 23);
+    EXPECT_EQ(*assigned.try_pop(), 2);
+    EXPECT_EQ(*assigned.try_pop(), 24);
+    EXPECT_EQ(assigned.getFairnessCount(), 2U);
+}
+
 /** test with a move only element*/
 TEST(blocking_priority_queue, move_only_tests)
 {
@@ -143,6 +212,49 @@ TEST(blocking_priority_queue, clear_tests)
     EXPECT_TRUE(queue.empty());
 }
 
+TEST(blocking_priority_queue, remove_if)
+{
+    BlockingPriorityQueue<std::pair<int, int>> queue;
+    for (int index = 0; index < 20; ++index) {
+        queue.emplace(index % 4, index);
+    }
+    // move part of the queue into the pull side
+    auto popped_value = queue.try_pop();
+    EXPECT_EQ(popped_value->second, 0);
+    for (int index = 20; index < 30; ++index) {
+        queue.emplace(index % 4, index);
+    }
+    for (int index = 0; index < 6; ++index) {
+        queue.emplacePriority(index % 2, -index);
+    }
+    auto removed = queue.remove_if(
+        [](const std::pair<int, int>& element) { return element.first == 1; });
+    EXPECT_EQ(removed, 11U);
+    const std::vector<int> expected_priority{0, -2, -4};
+    for (auto expected : expected_priority) {
+        popped_value = queue.try_pop();
+        EXPECT_EQ(popped_value->second, expected);
+    }
+    int previous{0};
+    int count{0};
+    popped_value = queue.try_pop();
+    while (popped_value) {
+        EXPECT_NE(popped_value->first, 1);
+        EXPECT_GT(popped_value->second, previous);
+        previous = popped_value->second;
+        ++count;
+        popped_value = queue.try_pop();
+    }
+    EXPECT_EQ(count, 21);
+
+    queue.pushPriority(std::make_pair(1, 1));
+    removed = queue.remove_if(
+        [](const std::pair<int, int>& element) { return element.first == 1; });
+    EXPECT_EQ(removed, 1U);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.try_pop());
+}
+
 TEST(blocking_priority_queue, multithreaded_tests_wait)
 {
     BlockingPriorityQueue<std::pair<int64_t, int64_t>> queue;
@@ -457,3 +569,140 @@ TEST(blocking_priority_queue, pop_callback_tests)
     EXPECT_EQ(second_result, 127);
     EXPECT_EQ(push_count, 127 + 25);
 }
+
+/** test priority pushes from one thread alongside a large normal backlog*/
+TEST(blocking_priority_queue, priority_with_backlog)
+{
+    BlockingPriorityQueue<int64_t> queue;
+    queue.reserve(1'000'000);
+
+    auto producer = [&]() {
+        for (int64_t index = 0; index < 1'000'000; ++index) {
+            queue.push(index);
+        }
+        queue.push(-1);
+    };
+    auto priority_producer = [&]() {
+        for (int64_t index = 0; index < 1'000; ++index) {
+            queue.pushPriority(-10 - index);
+        }
+    };
+
+    auto producer_thread = std::thread(producer);
+    auto priority_thread = std::thread(priority_producer);
+    int64_t normal_count{0};
+    int64_t priority_count{0};
+    int64_t next_priority{-10};
+    bool in_order{true};
+    bool done{false};
+    while (!done || priority_count < 1'000) {
+        auto result = queue.pop();
+        if (result == -1) {
+            done = true;
+        } else if (result < -1) {
+            in_order = in_order && (result == next_priority);
+            --next_priority;
+            ++priority_count;
+        } else {
+            ++normal_count;
+        }
+    }
+    producer_thread.join();
+    priority_thread.join();
+    EXPECT_EQ(normal_count, 1'000'000);
+    EXPECT_EQ(priority_count, 1'000);
+    EXPECT_TRUE(in_order);
+    EXPECT_FALSE(queue.try_pop());
+    EXPECT_TRUE(queue.empty());
+}
+
+/** test priority elements handed to consumers parked in pop*/
+TEST(blocking_priority_queue, priority_handoff)
+{
+    BlockingPriorityQueue<std::unique_ptr<int>> queue;
+    auto waiting_consumer = [&queue]() { return *queue.pop(); };
+    auto timed_consumer = [&queue]() {
+        auto result = queue.pop(std::chrono::milliseconds(5000));
+        return (result) ? **result : -1;
+    };
+    auto first_result = std::async(std::launch::async, waiting_consumer);
+    auto second_result = std::async(std::launch::async, timed_consumer);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    queue.pushPriority(std::make_unique<int>(7));
+    queue.emplacePriority(std::make_unique<int>(8));
+    const int first_value = first_result.get();
+    const int second_value = second_result.get();
+    EXPECT_EQ(first_value + second_value, 15);
+    EXPECT_TRUE(first_value == 7 || first_value == 8);
+    EXPECT_FALSE(queue.try_pop());
+
+    // normal pushes still wake parked consumers
+    auto third_result = std::async(std::launch::async, waiting_consumer);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    queue.push(std::make_unique<int>(9));
+    EXPECT_EQ(third_result.get(), 9);
+    EXPECT_FALSE(queue.try_pop());
+}
+
+/** test popping from a single lane of the queue*/
+TEST(blocking_priority_queue, lane_selective_pop)
+{
+    BlockingPriorityQueue<int> queue;
+    queue.push(1);
+    queue.push(2);
+    EXPECT_FALSE(queue.try_pop_priority());
+    EXPECT_FALSE(queue.pop_priority(std::chrono::milliseconds(20)));
+    queue.pushPriority(10);
+    EXPECT_EQ(*queue.try_pop_normal(), 1);
+    EXPECT_EQ(queue.pop_priority(), 10);
+    EXPECT_FALSE(queue.try_pop_priority());
+    EXPECT_EQ(queue.pop_normal(), 2);
+    EXPECT_TRUE(queue.empty());
+
+    queue.pushPriority(11);
+    EXPECT_FALSE(queue.try_pop_normal());
+    EXPECT_FALSE(queue.pop_normal(std::chrono::milliseconds(20)));
+    EXPECT_FALSE(queue.empty());
+
+    // a control thread parked on the priority lane does not take normal data
+    auto control = std::async(std::launch::async, [&queue]() {
+        std::vector<int> values;
+        values.push_back(queue.pop_priority());
+        values.push_back(queue.pop_priority());
+        return values;
+    });
+    auto data = std::async(std::launch::async, [&queue]() {
+        std::vector<int> values;
+        for (int index = 0; index < 3; ++index) {
+            values.push_back(queue.pop_normal());
+        }
+        return values;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    queue.push(3);
+    queue.push(4);
+    queue.push(5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    queue.pushPriority(12);
+    EXPECT_EQ(control.get(), (std::vector<int>{11, 12}));
+    EXPECT_EQ(data.get(), (std::vector<int>{3, 4, 5}));
+    EXPECT_TRUE(queue.empty());
+}
+
+/** lane-selective pops do not count toward the fairness ratio*/
+TEST(blocking_priority_queue, lane_selective_pop_ratio)
+{
+    BlockingPriorityQueue<int> queue;
+    queue.setPriorityRatio(2);
+    queue.push(1);
+    queue.pushPriority(10);
+    queue.pushPriority(11);
+    queue.pushPriority(12);
+    queue.pushPriority(13);
+    EXPECT_EQ(queue.pop_priority(), 10);
+    EXPECT_EQ(*queue.try_pop_priority(), 11);
+    EXPECT_EQ(*queue.try_pop(), 12);
+    EXPECT_EQ(*queue.try_pop(), 13);
+    EXPECT_EQ(*queue.try_pop(), 1);
+    EXPECT_EQ(queue.getFairnessCount(), 0U);
+}
@@ -294,3 +294,60 @@ TEST(simple_queue_tests, pop_test)
     EXPECT_TRUE(queue.pop());
     EXPECT_TRUE(queue.pop());
 }
+
+/** test the ordering of moved vectors in each state of the queue*/
+TEST(simple_queue_tests, push_vector_move)
+{
+    SimpleQueue<std::unique_ptr<int>> queue;
+    auto make_batch = [](int start) {
+        std::vector<std::unique_ptr<int>> batch;
+        for (int ii = start; ii < start + 3; ++ii) {
+            batch.push_back(std::make_unique<int>(ii));
+        }
+        return batch;
+    };
+    auto batch = make_batch(0);
+    // an empty queue takes over the buffer on the push side
+    queue.pushVector(std::move(batch));
+    EXPECT_TRUE(batch.empty());
+    EXPECT_FALSE(queue.empty());
+    auto first = queue.pop();
+    ASSERT_TRUE(first);
+    EXPECT_EQ(**first, 0);
+    // the pull side now holds elements, the push side is empty
+    queue.pushVector(make_batch(3));
+    // both sides hold elements
+    queue.pushVector(make_batch(6));
+    queue.push(std::make_unique<int>(9));
+    for (int ii = 1; ii < 10; ++ii) {
+        auto result = queue.pop();
+        ASSERT_TRUE(result);
+        EXPECT_EQ(**result, ii);
+    }
+    EXPECT_FALSE(queue.pop());
+
+    SimpleQueue<int> values;
+    values.pushVector(std::vector<int>{1, 2, 3});
+    EXPECT_EQ(values.peek(), 1);
+    EXPECT_EQ(values.size(), 3U);
+    EXPECT_EQ(values.pop(), 1);
+    EXPECT_EQ(values.peek(), 2);
+}
+
+/** pushing an empty vector leaves an empty queue empty*/
+TEST(simple_queue_tests, push_vector_empty)
+{
+    SimpleQueue<std::unique_ptr<int>> queue;
+    queue.pushVector(std::vector<std::unique_ptr<int>>{});
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop());
+
+    SimpleQueue<int> copied;
+    const std::vector<int> nothing;
+    copied.pushVector(nothing);
+    EXPECT_TRUE(copied.empty());
+    copied.push(3);
+    copied.pushVector(nothing);
+    EXPECT_EQ(copied.pop(), 3);
+    EXPECT_TRUE(copied.empty());
+}
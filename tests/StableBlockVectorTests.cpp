@@ -11,6 +11,7 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 #include <atomic>
 #include <cstddef>
 #include <cstdlib>
+#include <iterator>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -601,3 +602,36 @@ TEST(stableBlockVectorTest, iterator_tests)
     EXPECT_TRUE(iterator);
     EXPECT_TRUE(const_iterator);
 }
+
+TEST(stableBlockVectorTest, random_access_iterator)
+{
+    StableBlockVector<int, 3> stable_block_vector;
+    for (int index = 0; index < 37; ++index) {
+        stable_block_vector.push_back(index);
+    }
+    auto begin = stable_block_vector.begin();
+    auto end = stable_block_vector.end();
+    EXPECT_EQ(end - begin, 37);
+    EXPECT_EQ(std::distance(begin, end), 37);
+    EXPECT_EQ(begin[20], 20);
+    auto middle = begin + 19;
+    EXPECT_EQ(middle - begin, 19);
+    EXPECT_EQ(begin - middle, -19);
+    EXPECT_EQ(*(middle + -10), 9);
+    EXPECT_EQ(*(middle - -10), 29);
+    EXPECT_EQ(*(3 + middle), 22);
+    EXPECT_TRUE(begin < middle);
+    EXPECT_TRUE(middle <= end);
+    EXPECT_TRUE(end > middle);
+    EXPECT_FALSE(begin >= middle);
+    EXPECT_TRUE(begin + 37 == end);
+
+    StableBlockVector<int, 3> full_blocks;
+    for (int index = 0; index < 16; ++index) {
+        full_blocks.push_back(index);
+    }
+    EXPECT_EQ(full_blocks.end() - full_blocks.begin(), 16);
+    const auto& const_full = full_blocks;
+    EXPECT_EQ(const_full.end() - const_full.begin(), 16);
+    EXPECT_EQ(const_full.begin()[15], 15);
+}
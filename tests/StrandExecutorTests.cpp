@@ -0,0 +1,201 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "StrandExecutor.hpp"
+
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using gmlc::containers::make_shared_workBlock;
+using gmlc::containers::StrandExecutor;
+using gmlc::containers::WorkQueue;
+
+TEST(strandExecutor, ordering)
+{
+    WorkQueue work_queue(3);
+    StrandExecutor<int> strands(work_queue);
+    constexpr int keys{20};
+    constexpr int perKey{500};
+    // the values of a key are only touched from its strand, without locks
+    std::vector<std::vector<int>> seen(keys);
+    for (int ii = 0; ii < perKey; ++ii) {
+        for (int key = 0; key < keys; ++key) {
+            strands.post(key, [&seen, key, ii] { seen[key].push_back(ii); });
+        }
+    }
+    auto last = make_shared_workBlock([] {});
+    strands.post(0, last);
+    last->wait();
+    while (!strands.isIdle()) {
+        std::this_thread::yield();
+    }
+    for (int key = 0; key < keys; ++key) {
+        ASSERT_EQ(seen[key].size(), static_cast<std::size_t>(perKey));
+        for (int ii = 0; ii < perKey; ++ii) {
+            EXPECT_EQ(seen[key][ii], ii);
+        }
+    }
+    EXPECT_EQ(strands.activeStrands(), 0U);
+}
+
+TEST(strandExecutor, concurrent_keys)
+{
+    // each task waits for the other key to start, which only completes if
+    // the two strands run at the same time
+    WorkQueue work_queue(2);
+    StrandExecutor<std::string> strands(work_queue);
+    std::promise<void> firstStarted;
+    std::promise<void> secondStarted;
+    auto first = make_shared_workBlock(
+        [started = secondStarted.get_future().share(), &firstStarted] {
+            firstStarted.set_value();
+            started.wait();
+        });
+    auto second = make_shared_workBlock(
+        [started = firstStarted.get_future().share(), &secondStarted] {
+            secondStarted.set_value();
+            started.wait();
+        });
+    strands.post("first", first);
+    strands.post("second", second);
+    first->wait();
+    second->wait();
+}
+
+TEST(strandExecutor, serial_key)
+{
+    WorkQueue work_queue(4);
+    StrandExecutor<int> strands(work_queue);
+    std::atomic<int> running{0};
+    std::atomic<int> overlaps{0};
+    std::atomic<int> count{0};
+    for (int ii = 0; ii < 200; ++ii) {
+        strands.post(7, [&] {
+            if (++running > 1) {
+                ++overlaps;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            --running;
+            ++count;
+        });
+    }
+    while (count.load() < 200) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(overlaps.load(), 0);
+}
+
+TEST(strandExecutor, idle)
+{
+    WorkQueue work_queue(1);
+    StrandExecutor<int> strands(work_queue);
+    EXPECT_TRUE(strands.isIdle());
+    std::promise<void> gate;
+    auto blocker = make_shared_workBlock(
+        [started = gate.get_future().share()] { started.wait(); });
+    strands.post(1, blocker);
+    strands.post(1, [] {});
+    strands.post(2, [] {});
+    EXPECT_EQ(strands.activeStrands(), 2U);
+    // a finished block is not queued
+    auto finished = make_shared_workBlock([] {});
+    finished->execute();
+    strands.post(3, finished);
+    EXPECT_EQ(strands.activeStrands(), 2U);
+    gate.set_value();
+    while (!strands.isIdle()) {
+        std::this_thread::yield();
+    }
+    // a strand that was idle starts again on the next post
+    auto again = make_shared_workBlock([] { return 5; });
+    strands.post(1, again);
+    EXPECT_EQ(again->getReturnVal(), 5);
+}
+
+TEST(strandExecutor, outlived)
+{
+    WorkQueue work_queue(1);
+    auto block = make_shared_workBlock([] { return 3; });
+    {
+        StrandExecutor<int> strands(work_queue);
+        strands.post(1, [] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        });
+        strands.post(1, block);
+    }
+    EXPECT_EQ(block->getReturnVal(), 3);
+}
+
+TEST(strandExecutor, exceptions)
+{
+    WorkQueue work_queue(2);
+    StrandExecutor<int> strands(work_queue);
+    std::atomic<int> count{0};
+    strands.post(1, [] { throw(std::runtime_error("strand failure")); });
+    strands.post(1, [&count] { ++count; });
+    auto block = make_shared_workBlock(
+        []() -> int { throw(std::runtime_error("block failure")); });
+    strands.post(1, block);
+    EXPECT_THROW(block->getReturnVal(), std::runtime_error);
+    while (!strands.isIdle()) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(count.load(), 1);
+    EXPECT_EQ(work_queue.getTaskErrorCount(), 1U);
+    // the strand is still usable
+    auto last = make_shared_workBlock([] { return 5; });
+    strands.post(1, last);
+    EXPECT_EQ(last->getReturnVal(), 5);
+}
+
+TEST(strandExecutor, closed_queue)
+{
+    WorkQueue work_queue(1);
+    StrandExecutor<int> strands(work_queue);
+    work_queue.closeWorkerQueue();
+    std::atomic<int> count{0};
+    strands.post(3, [&count] { ++count; });
+    EXPECT_TRUE(strands.isIdle());
+    strands.post(3, [&count] { ++count; });
+    strands.post(4, [&count] { ++count; });
+    EXPECT_EQ(strands.activeStrands(), 0U);
+    EXPECT_EQ(count.load(), 0);
+}
+
+TEST(strandExecutor, runner_dropped_on_close)
+{
+    WorkQueue work_queue(1);
+    StrandExecutor<int> strands(work_queue);
+    std::promise<void> gate;
+    work_queue.addTask([started = gate.get_future().share()] {
+        started.wait();
+    });
+    std::atomic<int> count{0};
+    strands.post(5, [&count] { ++count; });
+    EXPECT_FALSE(strands.isIdle());
+    // closing drops the queued runner while the worker is still busy
+    std::thread release([&strands, &gate] {
+        const auto limit =
+            std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!strands.isIdle() && std::chrono::steady_clock::now() < limit) {
+            std::this_thread::yield();
+        }
+        gate.set_value();
+    });
+    work_queue.closeWorkerQueue();
+    release.join();
+    EXPECT_TRUE(strands.isIdle());
+    strands.post(5, [&count] { ++count; });
+    EXPECT_TRUE(strands.isIdle());
+    EXPECT_EQ(count.load(), 0);
+}
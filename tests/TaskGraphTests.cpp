@@ -0,0 +1,261 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "TaskGraph.hpp"
+
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using gmlc::containers::make_shared_workBlock;
+using gmlc::containers::TaskGraph;
+using gmlc::containers::WorkCancelled;
+using gmlc::containers::WorkQueue;
+
+TEST(taskGraph, then_chain)
+{
+    WorkQueue work_queue(2);
+    auto first = make_shared_workBlock([] { return 4; });
+    auto second = work_queue.then(first, [](int val) { return val * 3; });
+    auto third =
+        work_queue.then(second, [](int val) { return std::to_string(val); });
+    auto last = work_queue.then(third, [](const std::string& val) {
+        EXPECT_EQ(val, "12");
+    });
+    EXPECT_FALSE(second->isFinished());
+    work_queue.addWorkBlock(first);
+    EXPECT_EQ(third->getReturnVal(), "12");
+    last->wait();
+    EXPECT_TRUE(last->isFinished());
+}
+
+TEST(taskGraph, then_completed)
+{
+    WorkQueue work_queue(1);
+    auto first = make_shared_workBlock([] {});
+    work_queue.addWorkBlock(first);
+    first->wait();
+    auto second = work_queue.then(first, [] { return 7; });
+    EXPECT_EQ(second->getReturnVal(), 7);
+}
+
+TEST(taskGraph, then_exception)
+{
+    WorkQueue work_queue(1);
+    auto first = make_shared_workBlock([]() -> int {
+        throw(std::runtime_error("failed"));
+    });
+    std::atomic<bool> called{false};
+    auto second = work_queue.then(first, [&called](int val) {
+        called = true;
+        return val;
+    });
+    work_queue.addWorkBlock(first);
+    EXPECT_THROW(second->getReturnVal(), std::runtime_error);
+    EXPECT_FALSE(called.load());
+}
+
+TEST(taskGraph, then_single_worker)
+{
+    // a continuation chain longer than the worker count must not deadlock
+    WorkQueue work_queue(1);
+    auto block = make_shared_workBlock([] { return 0; });
+    auto first = block;
+    for (int ii = 0; ii < 100; ++ii) {
+        block = work_queue.then(block, [](int val) { return val + 1; });
+    }
+    work_queue.addWorkBlock(first);
+    EXPECT_EQ(block->getReturnVal(), 100);
+}
+
+TEST(taskGraph, then_closed_queue)
+{
+    auto first = make_shared_workBlock([] { return 1; });
+    std::shared_ptr<gmlc::containers::WorkBlock<int>> second;
+    {
+        WorkQueue work_queue(1);
+        second = work_queue.then(first, [](int val) { return val + 1; });
+        work_queue.closeWorkerQueue();
+        auto closed = work_queue.then(first, [](int val) { return val + 2; });
+        first->execute();
+        EXPECT_THROW(closed->getReturnVal(), WorkCancelled);
+    }
+    EXPECT_THROW(second->getReturnVal(), WorkCancelled);
+
+    // the queue may be gone by the time the predecessor completes
+    auto later = make_shared_workBlock([] { return 1; });
+    std::shared_ptr<gmlc::containers::WorkBlock<int>> orphan;
+    {
+        WorkQueue work_queue(1);
+        orphan = work_queue.then(later, [](int val) { return val + 1; });
+    }
+    later->execute();
+    EXPECT_THROW(orphan->getReturnVal(), WorkCancelled);
+}
+
+TEST(taskGraph, continuation_exception)
+{
+    // a throwing continuation does not reach the worker completing the block
+    WorkQueue work_queue(1);
+    std::atomic<bool> called{false};
+    auto block = make_shared_workBlock([] { return 3; });
+    block->onCompletion([] { throw(std::runtime_error("continuation")); });
+    block->onCompletion([&called] { called = true; });
+    auto next = work_queue.then(block, [](int val) { return val * 2; });
+    work_queue.addWorkBlock(block);
+    EXPECT_EQ(block->getReturnVal(), 3);
+    EXPECT_EQ(next->getReturnVal(), 6);
+    EXPECT_TRUE(called.load());
+}
+
+TEST(taskGraph, diamond)
+{
+    WorkQueue work_queue(3);
+    TaskGraph graph;
+    std::mutex orderLock;
+    std::vector<int> order;
+    auto record = [&orderLock, &order](int val) {
+        return [&orderLock, &order, val]() {
+            std::lock_guard<std::mutex> lock(orderLock);
+            order.push_back(val);
+        };
+    };
+    auto start = graph.addTask(record(1));
+    auto left = graph.addTask(record(2));
+    auto right = graph.addTask(record(3));
+    auto finish = graph.addTask(record(4));
+    graph.addDependency(start, left);
+    graph.addDependency(start, right);
+    graph.addDependency(left, finish);
+    graph.addDependency(right, finish);
+    EXPECT_EQ(graph.size(), 4U);
+
+    auto done = graph.submit(work_queue);
+    EXPECT_TRUE(graph.empty());
+    ASSERT_EQ(
+        done.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    done.get();
+    ASSERT_EQ(order.size(), 4U);
+    EXPECT_EQ(order.front(), 1);
+    EXPECT_EQ(order.back(), 4);
+}
+
+TEST(taskGraph, wide)
+{
+    WorkQueue work_queue(2);
+    TaskGraph graph;
+    std::atomic<int> stage{0};
+    std::atomic<int> errors{0};
+    auto root = graph.addTask([&stage] { stage = 1; });
+    auto sink = graph.addTask([&stage, &errors] {
+        if (stage.load() != 1) {
+            ++errors;
+        }
+    });
+    std::atomic<int> middle{0};
+    for (int ii = 0; ii < 200; ++ii) {
+        auto id = graph.addTask([&stage, &errors, &middle] {
+            if (stage.load() != 1) {
+                ++errors;
+            }
+            ++middle;
+        });
+        graph.addDependency(root, id);
+        graph.addDependency(id, sink);
+    }
+    graph.submit(work_queue).get();
+    EXPECT_EQ(middle.load(), 200);
+    EXPECT_EQ(errors.load(), 0);
+}
+
+TEST(taskGraph, inline_queue)
+{
+    WorkQueue work_queue(0);
+    TaskGraph graph;
+    int value = 1;
+    auto first = graph.addTask([&value] { value += 2; });
+    auto second = graph.addTask([&value] { value *= 5; });
+    graph.addDependency(first, second);
+    auto done = graph.submit(work_queue);
+    EXPECT_EQ(
+        done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_EQ(value, 15);
+}
+
+TEST(taskGraph, errors)
+{
+    WorkQueue work_queue(1);
+    TaskGraph graph;
+    auto first = graph.addTask([] {});
+    auto second = graph.addTask([] {});
+    EXPECT_THROW(graph.addDependency(first, 5), std::out_of_range);
+    graph.addDependency(first, second);
+    graph.addDependency(second, first);
+    EXPECT_THROW(graph.submit(work_queue), std::invalid_argument);
+
+    TaskGraph failing;
+    std::atomic<bool> skipped{true};
+    auto thrower =
+        failing.addTask([] { throw(std::runtime_error("task failed")); });
+    auto after = failing.addTask([&skipped] { skipped = false; });
+    failing.addDependency(thrower, after);
+    auto done = failing.submit(work_queue);
+    EXPECT_THROW(done.get(), std::runtime_error);
+    EXPECT_TRUE(skipped.load());
+
+    TaskGraph empty;
+    EXPECT_NO_THROW(empty.submit(work_queue).get());
+}
+
+TEST(taskGraph, closed_queue)
+{
+    WorkQueue work_queue(1);
+    TaskGraph graph;
+    std::promise<void> gate;
+    std::atomic<bool> started{false};
+    std::atomic<bool> skipped{true};
+    auto first = graph.addTask(
+        [&started, release = gate.get_future().share()] {
+            started = true;
+            release.wait();
+        });
+    auto second = graph.addTask([&skipped] { skipped = false; });
+    graph.addDependency(first, second);
+    auto done = graph.submit(work_queue);
+    while (!started.load()) {
+        std::this_thread::yield();
+    }
+    auto closing = std::async(std::launch::async, [&work_queue] {
+        work_queue.closeWorkerQueue();
+    });
+    while (work_queue.getWorkerCount() != 0) {
+        std::this_thread::yield();
+    }
+    gate.set_value();
+    closing.get();
+    ASSERT_EQ(
+        done.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_THROW(done.get(), WorkCancelled);
+    EXPECT_TRUE(skipped.load());
+
+    // a graph submitted to a closed queue completes right away
+    TaskGraph late;
+    late.addTask([&skipped] { skipped = false; });
+    auto rejected = late.submit(work_queue);
+    ASSERT_EQ(
+        rejected.wait_for(std::chrono::seconds(0)),
+        std::future_status::ready);
+    EXPECT_THROW(rejected.get(), WorkCancelled);
+    EXPECT_TRUE(skipped.load());
+}
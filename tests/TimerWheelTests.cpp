@@ -0,0 +1,187 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "TimerWheel.hpp"
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+using gmlc::containers::TimerHandle;
+using gmlc::containers::TimerWheel;
+
+using std::chrono::milliseconds;
+using clock_type = std::chrono::steady_clock;
+
+TEST(timerWheelTest, single_shot)
+{
+    const auto start = clock_type::now();
+    TimerWheel<int> wheel(milliseconds(1), start);
+    EXPECT_TRUE(wheel.empty());
+    wheel.insert(start + milliseconds(5), 5);
+    wheel.insert(start + milliseconds(2), 2);
+    wheel.insert(start + milliseconds(70), 70);
+    EXPECT_EQ(wheel.size(), 3U);
+
+    std::vector<int> fired;
+    auto record = [&fired](int& value) { fired.push_back(value); };
+    wheel.advance(start + milliseconds(1), record);
+    EXPECT_TRUE(fired.empty());
+    wheel.advance(start + milliseconds(5), record);
+    EXPECT_EQ(fired, (std::vector<int>{2, 5}));
+    wheel.advance(start + milliseconds(69), record);
+    EXPECT_EQ(fired.size(), 2U);
+    wheel.advance(start + milliseconds(100), record);
+    EXPECT_EQ(fired, (std::vector<int>{2, 5, 70}));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(timerWheelTest, cancel)
+{
+    const auto start = clock_type::now();
+    TimerWheel<int> wheel(milliseconds(1), start);
+    auto first = wheel.insert(start + milliseconds(10), 1);
+    auto second = wheel.insert(start + milliseconds(10), 2);
+    auto far = wheel.insert(start + milliseconds(100000), 3);
+    EXPECT_TRUE(wheel.isPending(second));
+    EXPECT_TRUE(wheel.cancel(second));
+    EXPECT_FALSE(wheel.cancel(second));
+    EXPECT_FALSE(wheel.isPending(second));
+    EXPECT_TRUE(wheel.cancel(far));
+    EXPECT_EQ(wheel.size(), 1U);
+
+    std::vector<int> fired;
+    wheel.advance(
+        start + milliseconds(200000), [&fired](int& value) {
+            fired.push_back(value);
+        });
+    EXPECT_EQ(fired, (std::vector<int>{1}));
+    EXPECT_FALSE(wheel.cancel(first));
+    EXPECT_FALSE(wheel.cancel(TimerHandle{}));
+
+    // a reused node does not match the old handle
+    auto reused = wheel.insert(start + milliseconds(200010), 4);
+    EXPECT_EQ(reused.index, first.index);
+    EXPECT_FALSE(wheel.isPending(first));
+    EXPECT_TRUE(wheel.isPending(reused));
+}
+
+TEST(timerWheelTest, periodic)
+{
+    const auto start = clock_type::now();
+    TimerWheel<int> wheel(milliseconds(1), start);
+    auto handle =
+        wheel.insert(start + milliseconds(10), 7, milliseconds(10));
+    int count = 0;
+    auto counter = [&count](int& value) {
+        EXPECT_EQ(value, 7);
+        ++count;
+    };
+    for (int time = 1; time <= 35; ++time) {
+        wheel.advance(start + milliseconds(time), counter);
+    }
+    EXPECT_EQ(count, 3);
+    EXPECT_TRUE(wheel.isPending(handle));
+    // missed periods are skipped rather than fired in a burst
+    wheel.advance(start + milliseconds(1000), counter);
+    EXPECT_EQ(count, 4);
+    wheel.advance(start + milliseconds(1009), counter);
+    EXPECT_EQ(count, 4);
+    wheel.advance(start + milliseconds(1010), counter);
+    EXPECT_EQ(count, 5);
+    EXPECT_TRUE(wheel.cancel(handle));
+    wheel.advance(start + milliseconds(2000), counter);
+    EXPECT_EQ(count, 5);
+}
+
+TEST(timerWheelTest, next_event)
+{
+    const auto start = clock_type::now();
+    TimerWheel<int> wheel(milliseconds(1), start);
+    EXPECT_FALSE(wheel.nextEventTime());
+    wheel.insert(start + milliseconds(3), 1);
+    EXPECT_EQ(*wheel.nextEventTime(), start + milliseconds(3));
+    wheel.insert(start + milliseconds(5000), 2);
+    EXPECT_EQ(*wheel.nextEventTime(), start + milliseconds(3));
+    int fired = 0;
+    wheel.advance(start + milliseconds(3), [&fired](int& /*value*/) {
+        ++fired;
+    });
+    EXPECT_EQ(fired, 1);
+    // the next event is never later than the expiry of the pending timer
+    auto next = wheel.nextEventTime();
+    ASSERT_TRUE(next);
+    EXPECT_LE(*next, start + milliseconds(5000));
+    EXPECT_GT(*next, start + milliseconds(3));
+}
+
+TEST(timerWheelTest, random_expiries)
+{
+    const auto start = clock_type::now();
+    TimerWheel<std::int64_t> wheel(milliseconds(1), start);
+    std::mt19937_64 generator(42);
+    std::uniform_int_distribution<std::int64_t> delays(1, 20000000);
+    std::vector<TimerHandle> handles;
+    for (int ii = 0; ii < 20000; ++ii) {
+        const auto delay = (ii % 3 == 0) ? delays(generator) % 500 + 1 :
+                                           delays(generator);
+        handles.push_back(wheel.insert(start + milliseconds(delay), delay));
+    }
+    std::size_t cancelled{0};
+    for (std::size_t ii = 0; ii < handles.size(); ii += 7) {
+        if (wheel.cancel(handles[ii])) {
+            ++cancelled;
+        }
+    }
+    EXPECT_EQ(wheel.size(), handles.size() - cancelled);
+
+    std::int64_t now{0};
+    std::size_t fired{0};
+    std::int64_t late{0};
+    std::int64_t early{0};
+    auto check = [&](std::int64_t& expiry) {
+        ++fired;
+        if (expiry > now) {
+            ++early;
+        }
+        if (expiry < now - 1000) {
+            ++late;
+        }
+    };
+    while (!wheel.empty()) {
+        auto next = wheel.nextEventTime();
+        ASSERT_TRUE(next);
+        now = std::chrono::duration_cast<milliseconds>(*next - start).count();
+        wheel.advance(*next, check);
+    }
+    EXPECT_EQ(fired, handles.size() - cancelled);
+    EXPECT_EQ(early, 0);
+    EXPECT_EQ(late, 0);
+}
+
+TEST(timerWheelTest, coarse_resolution)
+{
+    const auto start = clock_type::now();
+    TimerWheel<int> wheel(milliseconds(10), start);
+    EXPECT_EQ(wheel.getResolution(), milliseconds(10));
+    wheel.insert(start + milliseconds(15), 1);
+    int fired = 0;
+    auto counter = [&fired](int& /*value*/) { ++fired; };
+    wheel.advance(start + milliseconds(15), counter);
+    EXPECT_EQ(fired, 0);
+    wheel.advance(start + milliseconds(20), counter);
+    EXPECT_EQ(fired, 1);
+    wheel.insert(start + milliseconds(100), 2);
+    wheel.clear();
+    EXPECT_TRUE(wheel.empty());
+    wheel.advance(start + milliseconds(500), counter);
+    EXPECT_EQ(fired, 1);
+}
@@ -0,0 +1,103 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "WorkQueue.hpp"
+
+#include "gtest/gtest.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+using gmlc::containers::WorkQueue;
+
+// operator new is replaced for the whole executable, so the allocation
+// counting is kept apart from the other WorkQueue tests
+namespace {
+// allocations are only counted on a thread that sets this flag
+thread_local bool countAllocations{false};
+std::atomic<int> allocationCount{0};
+}  // namespace
+
+void* operator new(std::size_t size)
+{
+    if (countAllocations) {
+        ++allocationCount;
+    }
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+// gcc cannot see that operator new is replaced by the malloc version above
+#if defined(__GNUC__) && !defined(__clang__)
+#    pragma GCC diagnostic push
+#    pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept
+{
+    std::free(ptr);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#    pragma GCC diagnostic pop
+#endif
+
+TEST(work_queue_allocation, addTask_allocation_free)
+{
+    constexpr int taskCount = 200;
+    WorkQueue work_queue(1);
+    std::atomic<int> executed{0};
+    std::atomic<bool> release{false};
+    std::array<char, 180> payload{};
+    payload.front() = 1;
+
+    auto runRound = [&]() {
+        const int start = executed.load();
+        // hold the worker so every task is queued before any runs
+        work_queue.addTask([&release] {
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+        });
+        for (int ii = 0; ii < taskCount; ++ii) {
+            if (ii % 2 == 0) {
+                work_queue.addTask([&executed] { ++executed; });
+            } else {
+                work_queue.addTask([&executed, payload] {
+                    executed += payload.front();
+                });
+            }
+        }
+        release.store(true);
+        while (executed.load() < start + taskCount) {
+            std::this_thread::yield();
+        }
+        while (!work_queue.isEmpty()) {
+            std::this_thread::yield();
+        }
+        release.store(false);
+    };
+    // warm up the queue capacity and fill the storage pool caches
+    for (int ii = 0; ii < 16; ++ii) {
+        runRound();
+    }
+    allocationCount.store(0);
+    countAllocations = true;
+    runRound();
+    countAllocations = false;
+    EXPECT_EQ(allocationCount.load(), 0);
+    EXPECT_EQ(executed.load(), 17 * taskCount);
+}
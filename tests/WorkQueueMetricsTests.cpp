@@ -0,0 +1,118 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "WorkQueue.hpp"
+
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using gmlc::containers::DurationHistogram;
+using gmlc::containers::make_shared_workBlock;
+using gmlc::containers::WorkQueue;
+
+static_assert(WorkQueue::metricsEnabled, "metrics must be compiled in");
+
+TEST(work_queue_metrics, histogram)
+{
+    EXPECT_EQ(DurationHistogram::bucketOf(0), 0U);
+    EXPECT_EQ(DurationHistogram::bucketOf(1), 1U);
+    EXPECT_EQ(DurationHistogram::bucketOf(1023), 10U);
+    EXPECT_EQ(DurationHistogram::bucketOf(1024), 11U);
+    EXPECT_EQ(
+        DurationHistogram::bucketOf(std::int64_t{1} << 50),
+        DurationHistogram::bucketCount - 1);
+
+    DurationHistogram histogram;
+    EXPECT_EQ(histogram.percentile(0.5).count(), 0);
+    for (int ii = 0; ii < 90; ++ii) {
+        ++histogram.buckets[DurationHistogram::bucketOf(100)];
+    }
+    for (int ii = 0; ii < 10; ++ii) {
+        ++histogram.buckets[DurationHistogram::bucketOf(5000)];
+    }
+    histogram.count = 100;
+    histogram.total = std::chrono::nanoseconds(90 * 100 + 10 * 5000);
+    histogram.max = std::chrono::nanoseconds(5000);
+    EXPECT_EQ(histogram.mean().count(), 590);
+    EXPECT_EQ(histogram.percentile(0.5).count(), 128);
+    EXPECT_EQ(histogram.percentile(0.99).count(), 5000);
+}
+
+TEST(work_queue_metrics, wait_and_execution)
+{
+    WorkQueue work_queue(1);
+    std::promise<void> gate;
+    auto blocker = make_shared_workBlock(
+        [started = gate.get_future().share()] { started.wait(); });
+    work_queue.addWorkBlock(blocker, WorkQueue::WorkPriority::high);
+    std::vector<std::shared_ptr<gmlc::containers::WorkBlock<void>>> blocks;
+    for (int ii = 0; ii < 10; ++ii) {
+        blocks.push_back(make_shared_workBlock([] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }));
+        work_queue.addWorkBlock(blocks.back(), WorkQueue::WorkPriority::low);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    gate.set_value();
+    for (auto& block : blocks) {
+        block->wait();
+    }
+    // the metrics of the last block are recorded after its future is ready
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    auto metrics = work_queue.getMetrics();
+    const auto& low = metrics[WorkQueue::WorkPriority::low];
+    EXPECT_EQ(low.queueWait.count, 10U);
+    EXPECT_EQ(low.execution.count, 10U);
+    EXPECT_GE(low.queueWait.max, std::chrono::milliseconds(20));
+    EXPECT_GE(low.execution.mean(), std::chrono::milliseconds(2));
+    EXPECT_EQ(metrics[WorkQueue::WorkPriority::high].execution.count, 1U);
+    EXPECT_EQ(metrics[WorkQueue::WorkPriority::medium].queueWait.count, 0U);
+    EXPECT_GE(metrics.busyTime, std::chrono::milliseconds(40));
+    EXPECT_GT(metrics.utilization(), 0.0);
+    EXPECT_LE(metrics.utilization(), 1.0);
+}
+
+TEST(work_queue_metrics, priority_ratio)
+{
+    WorkQueue work_queue(1);
+    std::promise<void> gate;
+    auto blocker = make_shared_workBlock(
+        [started = gate.get_future().share()] { started.wait(); });
+    work_queue.addWorkBlock(blocker, WorkQueue::WorkPriority::high);
+    while (!work_queue.isEmpty()) {
+        std::this_thread::yield();
+    }
+    work_queue.setPriorityRatio(3);
+    std::atomic<int> count{0};
+    for (int ii = 0; ii < 40; ++ii) {
+        work_queue.addTask(
+            [&count] { ++count; }, WorkQueue::WorkPriority::medium);
+        work_queue.addTask([&count] { ++count; }, WorkQueue::WorkPriority::low);
+    }
+    // take work in scheduling order while both priorities are queued
+    for (int ii = 0; ii < 20; ++ii) {
+        auto task = work_queue.getTask();
+        ASSERT_TRUE(task);
+        task();
+    }
+    auto metrics = work_queue.getMetrics();
+    EXPECT_EQ(metrics[WorkQueue::WorkPriority::medium].queueWait.count, 15U);
+    EXPECT_EQ(metrics[WorkQueue::WorkPriority::low].queueWait.count, 5U);
+    EXPECT_DOUBLE_EQ(metrics.achievedPriorityRatio(), 3.0);
+    // work taken outside the workers has no execution time
+    EXPECT_EQ(metrics[WorkQueue::WorkPriority::medium].execution.count, 0U);
+    gate.set_value();
+    while (count.load() < 80) {
+        std::this_thread::yield();
+    }
+}
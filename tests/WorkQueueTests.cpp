@@ -19,23 +19,35 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 
 // Modified for gmlc/containers 7/23/2019
 
+#include "StableBlockVector.hpp"
 #include "WorkQueue.hpp"
 
 #include "gtest/gtest.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <functional>
+#include <future>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <thread>
 #include <utility>
 #include <vector>
 
 using gmlc::containers::BasicWorkBlock;
+using gmlc::containers::CancellationToken;
 using gmlc::containers::make_shared_workBlock;
 using gmlc::containers::make_workBlock;
+using gmlc::containers::WorkBlock;
+using gmlc::containers::WorkCancelled;
 using gmlc::containers::WorkQueue;
+using gmlc::containers::WorkTask;
 
 TEST(work_queue, WorkQueue_test1)
 {
@@ -270,3 +282,1073 @@ TEST(work_queue, WorkQueue_test3_vector)
     }
     EXPECT_EQ(difference_count, 0) << "Execution out of order";
 }
+
+TEST(work_queue, WorkQueue_stealing_order)
+{
+    // with a single worker externally added work is taken from the shared
+    // queues so the priority semantics match the shared mode
+    WorkQueue work_queue(1, WorkQueue::SchedulingMode::workStealing);
+    EXPECT_EQ(
+        work_queue.getSchedulingMode(),
+        WorkQueue::SchedulingMode::workStealing);
+    work_queue.setPriorityRatio(3);
+    std::vector<int> order;
+    std::mutex lock;
+    auto record = [&order, &lock](int value) {
+        return [&order, &lock, value] {
+            const std::lock_guard<std::mutex> queue_lock(lock);
+            order.push_back(value);
+        };
+    };
+    work_queue.addWorkBlock(
+        make_workBlock([] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        }),
+        WorkQueue::WorkPriority::high);
+    for (int index = 0; index < 3; ++index) {
+        work_queue.addWorkBlock(
+            make_workBlock(record(3)), WorkQueue::WorkPriority::low);
+    }
+    for (int index = 0; index < 9; ++index) {
+        work_queue.addWorkBlock(
+            make_workBlock(record(2)), WorkQueue::WorkPriority::medium);
+    }
+    for (int index = 0; index < 2; ++index) {
+        work_queue.addWorkBlock(
+            make_workBlock(record(1)), WorkQueue::WorkPriority::high);
+    }
+    auto final_block = make_shared_workBlock([] {});
+    work_queue.addWorkBlock(final_block, WorkQueue::WorkPriority::low);
+    final_block->wait();
+    const std::lock_guard<std::mutex> queue_lock(lock);
+    const std::vector<int> correct_order = {
+        1, 1, 2, 2, 2, 3, 2, 2, 2, 3, 2, 2, 2, 3};
+    EXPECT_EQ(order, correct_order);
+}
+
+TEST(work_queue, WorkQueue_stealing_nested)
+{
+    WorkQueue work_queue(4, WorkQueue::SchedulingMode::workStealing);
+    constexpr int outer_count{20};
+    constexpr int inner_count{50};
+    std::atomic<int> executed{0};
+    std::vector<std::shared_ptr<WorkBlock<void>>> outer_blocks;
+    for (int outer = 0; outer < outer_count; ++outer) {
+        auto block = make_shared_workBlock([&work_queue, &executed] {
+            // submitted from a worker so these go to the local deque and
+            // are stolen by the other workers
+            for (int inner = 0; inner < inner_count; ++inner) {
+                work_queue.addWorkBlock(
+                    make_shared_workBlock([&executed] { ++executed; }),
+                    (inner % 2 == 0) ? WorkQueue::WorkPriority::medium :
+                                       WorkQueue::WorkPriority::low);
+            }
+            ++executed;
+        });
+        outer_blocks.push_back(block);
+        work_queue.addWorkBlock(block);
+    }
+    for (auto& block : outer_blocks) {
+        block->wait();
+    }
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (executed.load() < outer_count * (inner_count + 1) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(executed.load(), outer_count * (inner_count + 1));
+    EXPECT_TRUE(work_queue.isEmpty());
+    EXPECT_EQ(work_queue.numBlock(), 0U);
+}
+
+TEST(work_queue, WorkQueue_start_latency)
+{
+    // idle workers must be woken for every submission, so the start latency
+    // is bounded by scheduling delays rather than any polling interval
+    for (const int worker_count : {1, 4}) {
+        WorkQueue work_queue(worker_count);
+        std::chrono::steady_clock::duration worst{0};
+        for (int index = 0; index < 200; ++index) {
+            std::this_thread::sleep_for(
+                std::chrono::microseconds(100 * (index % 7)));
+            const auto submit_time = std::chrono::steady_clock::now();
+            auto block = make_shared_workBlock([] {
+                return std::chrono::steady_clock::now();
+            });
+            work_queue.addWorkBlock(block);
+            worst = std::max(worst, block->getReturnVal() - submit_time);
+        }
+        EXPECT_LT(worst, std::chrono::milliseconds(500))
+            << "worst start latency with " << worker_count << " workers";
+    }
+}
+
+TEST(work_queue, WorkTask_storage)
+{
+    int count = 0;
+    WorkTask small([&count] { ++count; });
+    EXPECT_TRUE(static_cast<bool>(small));
+    EXPECT_FALSE(small.getBlock());
+    WorkTask moved(std::move(small));
+    EXPECT_FALSE(static_cast<bool>(small));
+    moved();
+    EXPECT_EQ(count, 1);
+
+    std::array<int, 50> big{};
+    big.back() = 5;
+    WorkTask large([&count, big] { count += big.back(); });
+    moved = std::move(large);
+    moved();
+    EXPECT_EQ(count, 6);
+
+    auto block = make_shared_workBlock([] { return 7; });
+    WorkTask blockTask(block);
+    EXPECT_EQ(blockTask.getBlock(), block);
+    blockTask();
+    EXPECT_TRUE(block->isFinished());
+    EXPECT_EQ(block->getReturnVal(), 7);
+    blockTask.reset();
+    EXPECT_FALSE(static_cast<bool>(blockTask));
+}
+
+TEST(work_queue, WorkQueue_addTask_priority)
+{
+    WorkQueue work_queue(0);
+    int count = 0;
+    work_queue.addTask([&count] { ++count; });
+    EXPECT_EQ(count, 1);
+
+    WorkQueue threaded_queue(1);
+    auto done = make_shared_workBlock([] { return 1; });
+    threaded_queue.addTask(
+        [&count] { ++count; }, WorkQueue::WorkPriority::high);
+    threaded_queue.addWorkBlock(done, WorkQueue::WorkPriority::low);
+    EXPECT_EQ(done->getReturnVal(), 1);
+    threaded_queue.closeWorkerQueue();
+    EXPECT_EQ(count, 2);
+}
+
+TEST(work_queue, parallel_for_index)
+{
+    for (const int worker_count : {0, 1, 3}) {
+        WorkQueue work_queue(worker_count);
+        std::vector<int> values(1000, 0);
+        work_queue.parallel_for(0, 1000, 16, [&values](int index) {
+            values[index] += index;
+        });
+        for (int index = 0; index < 1000; ++index) {
+            EXPECT_EQ(values[index], index);
+        }
+        int calls = 0;
+        work_queue.parallel_for(5, 5, 1, [&calls](int /*index*/) { ++calls; });
+        EXPECT_EQ(calls, 0);
+    }
+}
+
+TEST(work_queue, parallel_for_iterators)
+{
+    WorkQueue work_queue(2);
+    gmlc::containers::StableBlockVector<int, 4> stable_vector;
+    for (int index = 0; index < 500; ++index) {
+        stable_vector.push_back(index);
+    }
+    work_queue.parallel_for(
+        stable_vector.begin(), stable_vector.end(), 8, [](int& value) {
+            value *= 2;
+        });
+    int index = 0;
+    for (const auto& value : stable_vector) {
+        EXPECT_EQ(value, 2 * index);
+        ++index;
+    }
+    EXPECT_EQ(index, 500);
+
+    std::vector<std::atomic<int>> visits(300);
+    work_queue.parallel_for(
+        visits.begin(), visits.end(), 1, [](std::atomic<int>& visit) {
+            ++visit;
+        });
+    for (const auto& visit : visits) {
+        EXPECT_EQ(visit.load(), 1);
+    }
+}
+
+TEST(work_queue, parallel_reduce)
+{
+    WorkQueue work_queue(3);
+    const auto sum =
+        work_queue.parallel_reduce(1, 10001, 50, 0LL, std::plus<>());
+    EXPECT_EQ(sum, 50005000LL);
+
+    gmlc::containers::StableBlockVector<std::string, 3> words;
+    std::string expected;
+    for (int index = 0; index < 200; ++index) {
+        words.push_back(std::string(1, static_cast<char>('a' + index % 26)));
+        expected += words.back();
+    }
+    // concatenation is not commutative so the result checks the ordering
+    const auto joined = work_queue.parallel_reduce(
+        words.cbegin(),
+        words.cend(),
+        4,
+        std::string{},
+        [](std::string accumulated, const std::string& word) {
+            return accumulated + word;
+        },
+        [](std::string left, const std::string& right) {
+            return left + right;
+        });
+    EXPECT_EQ(joined, expected);
+}
+
+TEST(work_queue, parallel_for_nested_exception)
+{
+    WorkQueue work_queue(2);
+    std::atomic<int> total{0};
+    work_queue.parallel_for(0, 8, 1, [&work_queue, &total](int /*outer*/) {
+        work_queue.parallel_for(0, 100, 4, [&total](int /*inner*/) {
+            ++total;
+        });
+    });
+    EXPECT_EQ(total.load(), 800);
+
+    EXPECT_THROW(
+        work_queue.parallel_for(
+            0,
+            1000,
+            10,
+            [](int index) {
+                if (index == 503) {
+                    throw(std::runtime_error("failed"));
+                }
+            }),
+        std::runtime_error);
+    // the queue is still usable afterwards
+    const auto count = work_queue.parallel_reduce(
+        0,
+        100,
+        1,
+        0,
+        [](int value, int /*index*/) { return value + 1; },
+        std::plus<>());
+    EXPECT_EQ(count, 100);
+}
+
+TEST(work_queue, cpu_list_parsing)
+{
+    using gmlc::containers::detail::parseCpuList;
+    EXPECT_EQ(
+        parseCpuList("0-3,8,10-11\n"),
+        (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(parseCpuList("5"), (std::vector<int>{5}));
+    EXPECT_EQ(parseCpuList("4,2-3,2"), (std::vector<int>{2, 3, 4}));
+    EXPECT_TRUE(parseCpuList("").empty());
+    EXPECT_TRUE(parseCpuList("x,").empty());
+
+    const auto& topology = gmlc::containers::detail::CpuTopology::instance();
+    ASSERT_FALSE(topology.cpus.empty());
+    ASSERT_FALSE(topology.cores.empty());
+    ASSERT_FALSE(topology.nodes.empty());
+    for (auto cpu : topology.cpus) {
+        EXPECT_GE(topology.nodeOf(cpu), 0);
+    }
+}
+
+TEST(work_queue, worker_affinity)
+{
+    using gmlc::containers::WorkerAffinity;
+    const auto& topology = gmlc::containers::detail::CpuTopology::instance();
+    for (const auto& affinity :
+         {WorkerAffinity::perCore(true),
+          WorkerAffinity::perNumaNode(),
+          WorkerAffinity::cpuSet({topology.cpus.front()})}) {
+        WorkQueue work_queue(2, WorkQueue::SchedulingMode::shared, affinity);
+        std::vector<int> allowed;
+        for (int index = 0; index < 2; ++index) {
+            auto cpus = work_queue.getWorkerCpus(index);
+            EXPECT_FALSE(cpus.empty());
+            allowed.insert(allowed.end(), cpus.begin(), cpus.end());
+        }
+        EXPECT_TRUE(work_queue.getWorkerCpus(2).empty());
+        EXPECT_EQ(
+            work_queue.hasNumaLocalSubmission(),
+            affinity.numaLocalSubmission && topology.nodes.size() > 1);
+        std::atomic<int> misplaced{0};
+        std::vector<std::shared_ptr<BasicWorkBlock>> blocks;
+        for (int index = 0; index < 20; ++index) {
+            blocks.push_back(make_shared_workBlock([&allowed, &misplaced] {
+                const int cpu = gmlc::containers::detail::currentCpu();
+                if (cpu >= 0 &&
+                    std::find(allowed.begin(), allowed.end(), cpu) ==
+                        allowed.end()) {
+                    ++misplaced;
+                }
+            }));
+            work_queue.addWorkBlock(blocks.back());
+        }
+        for (auto& block : blocks) {
+            std::static_pointer_cast<WorkBlock<void>>(block)->wait();
+        }
+        EXPECT_EQ(misplaced.load(), 0);
+    }
+    WorkQueue unpinned(1);
+    EXPECT_TRUE(unpinned.getWorkerCpus(0).empty());
+    EXPECT_THROW(
+        WorkQueue(
+            1, WorkQueue::SchedulingMode::shared, WorkerAffinity::cpuSet({})),
+        std::invalid_argument);
+    EXPECT_THROW(
+        WorkQueue(
+            1, WorkQueue::SchedulingMode::shared, WorkerAffinity::cpuSet({-2})),
+        std::invalid_argument);
+}
+
+TEST(work_queue, elastic_workers)
+{
+    using gmlc::containers::WorkerScaling;
+    auto scaling = WorkerScaling::elastic(1, 4);
+    scaling.queueDepthThreshold = 1;
+    scaling.waitThreshold = std::chrono::milliseconds(5);
+    scaling.idleTimeout = std::chrono::milliseconds(100);
+    WorkQueue work_queue(scaling);
+    EXPECT_EQ(work_queue.getWorkerCount(), 1);
+    EXPECT_EQ(work_queue.getMinWorkerCount(), 1);
+    EXPECT_EQ(work_queue.getMaxWorkerCount(), 4);
+
+    std::vector<std::shared_ptr<WorkBlock<void>>> blocks;
+    int peak = 0;
+    for (int index = 0; index < 20; ++index) {
+        auto block = make_shared_workBlock([] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        });
+        work_queue.addWorkBlock(block);
+        blocks.push_back(std::move(block));
+        peak = std::max(peak, work_queue.getWorkerCount());
+    }
+    for (auto& block : blocks) {
+        block->wait();
+    }
+    EXPECT_GT(peak, 1);
+    EXPECT_LE(peak, 4);
+
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (work_queue.getWorkerCount() > 1 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    EXPECT_EQ(work_queue.getWorkerCount(), 1);
+
+    // retired slots are reused when the load returns
+    auto again = make_shared_workBlock([] { return 3; });
+    work_queue.addWorkBlock(again);
+    EXPECT_EQ(again->getReturnVal(), 3);
+}
+
+TEST(work_queue, elastic_from_zero)
+{
+    using gmlc::containers::WorkerScaling;
+    auto scaling = WorkerScaling::elastic(0, 2);
+    scaling.idleTimeout = std::chrono::milliseconds(200);
+    WorkQueue work_queue(scaling, WorkQueue::SchedulingMode::workStealing);
+    EXPECT_EQ(work_queue.getWorkerCount(), 0);
+    for (int round = 0; round < 3; ++round) {
+        auto block = make_shared_workBlock([] { return 5; });
+        work_queue.addWorkBlock(block);
+        EXPECT_EQ(block->getReturnVal(), 5);
+        EXPECT_GE(work_queue.getWorkerCount(), 1);
+        const auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (work_queue.getWorkerCount() > 0 &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_EQ(work_queue.getWorkerCount(), 0);
+    }
+    work_queue.closeWorkerQueue();
+    EXPECT_EQ(work_queue.getWorkerCount(), 0);
+}
+
+TEST(work_queue, delayed_work)
+{
+    WorkQueue work_queue(2);
+    const auto start = std::chrono::steady_clock::now();
+    auto block = make_shared_workBlock(
+        [] { return std::chrono::steady_clock::now(); });
+    work_queue.addDelayedWork(std::chrono::milliseconds(30), block);
+    std::atomic<int> count{0};
+    auto cancelled = work_queue.addDelayedWork(
+        std::chrono::milliseconds(40), [&count] { ++count; });
+    EXPECT_EQ(work_queue.getTimerCount(), 2U);
+    EXPECT_TRUE(work_queue.cancelTimer(cancelled));
+    EXPECT_FALSE(work_queue.cancelTimer(cancelled));
+    EXPECT_GE(block->getReturnVal() - start, std::chrono::milliseconds(30));
+
+    std::vector<gmlc::containers::TimerHandle> handles;
+    for (int index = 0; index < 10000; ++index) {
+        handles.push_back(work_queue.addDelayedWork(
+            std::chrono::seconds(100 + index % 1000), [&count] { ++count; }));
+    }
+    EXPECT_EQ(work_queue.getTimerCount(), 10000U);
+    for (const auto& handle : handles) {
+        EXPECT_TRUE(work_queue.cancelTimer(handle));
+    }
+    EXPECT_EQ(work_queue.getTimerCount(), 0U);
+    EXPECT_EQ(count.load(), 0);
+}
+
+TEST(work_queue, periodic_work)
+{
+    WorkQueue work_queue(1);
+    std::atomic<int> count{0};
+    auto handle = work_queue.addPeriodicWork(
+        std::chrono::milliseconds(5), [&count] { ++count; });
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (count.load() < 5 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_GE(count.load(), 5);
+    EXPECT_TRUE(work_queue.cancelTimer(handle));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const int stopped = count.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(count.load(), stopped);
+
+    // closing the queue drops pending timers
+    work_queue.addPeriodicWork(std::chrono::milliseconds(1), [] {});
+    work_queue.closeWorkerQueue();
+    EXPECT_EQ(work_queue.getTimerCount(), 0U);
+    EXPECT_FALSE(work_queue
+                     .addDelayedWork(std::chrono::milliseconds(1), [] {})
+                     .valid());
+}
+
+TEST(work_queue, task_exceptions)
+{
+    WorkQueue work_queue(1);
+    std::atomic<int> count{0};
+    // a throwing periodic callable keeps running on its schedule
+    auto handle = work_queue.addPeriodicWork(
+        std::chrono::milliseconds(2), [&count] {
+            ++count;
+            throw(std::runtime_error("periodic failure"));
+        });
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (count.load() < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_GE(count.load(), 3);
+    work_queue.cancelTimer(handle);
+
+    work_queue.addTask([] { throw(std::runtime_error("task failure")); });
+    work_queue.addBatchedTask([] { throw(std::runtime_error("batched")); });
+    work_queue.addBatchedTask([&count] { count += 100; });
+    work_queue.flushBatches();
+    // queued behind the batch in the medium lane
+    auto last = make_shared_workBlock([] {});
+    work_queue.addWorkBlock(last);
+    last->wait();
+    EXPECT_GE(count.load(), 103);
+    EXPECT_GE(work_queue.getTaskErrorCount(), 5U);
+
+    // without workers the exception is dropped on the calling thread
+    WorkQueue inline_queue(0);
+    EXPECT_NO_THROW(
+        inline_queue.addTask([] { throw(std::runtime_error("inline")); }));
+    EXPECT_EQ(inline_queue.getTaskErrorCount(), 1U);
+}
+
+TEST(work_queue, cancel_block)
+{
+    WorkQueue work_queue(1);
+    std::promise<void> gate;
+    auto blocker = make_shared_workBlock(
+        [started = gate.get_future().share()] { started.wait(); });
+    work_queue.addWorkBlock(blocker, WorkQueue::WorkPriority::high);
+
+    std::atomic<int> count{0};
+    auto block = make_shared_workBlock([&count] {
+        ++count;
+        return 5;
+    });
+    auto next = work_queue.then(block, [](int val) { return val + 1; });
+    auto handle = work_queue.addWorkBlock(block);
+    EXPECT_TRUE(handle.cancel());
+    EXPECT_FALSE(handle.cancel());
+    EXPECT_TRUE(handle.isCancelled());
+    EXPECT_TRUE(block->isFinished());
+    EXPECT_THROW(block->getReturnVal(), WorkCancelled);
+
+    gate.set_value();
+    EXPECT_THROW(next->getReturnVal(), WorkCancelled);
+    blocker->wait();
+    EXPECT_FALSE(blocker->cancel());
+    EXPECT_FALSE(blocker->isCancelled());
+    EXPECT_EQ(count.load(), 0);
+
+    // a cancelled block can be reset and run again
+    block->reset();
+    EXPECT_FALSE(block->isCancelled());
+    work_queue.addWorkBlock(block);
+    EXPECT_EQ(block->getReturnVal(), 5);
+    EXPECT_EQ(count.load(), 1);
+
+    std::packaged_task<int()> task([] { return 3; });
+    auto packaged = make_shared_workBlock(std::move(task));
+    EXPECT_TRUE(packaged->cancel());
+    EXPECT_THROW(packaged->getReturnVal(), WorkCancelled);
+    EXPECT_THROW(packaged->get_future().get(), std::future_error);
+
+    // a packaged task runs without another wrapper and can be run again
+    std::packaged_task<int()> again([&count] { return ++count; });
+    auto rerun = make_shared_workBlock(std::move(again));
+    work_queue.addWorkBlock(rerun);
+    EXPECT_EQ(rerun->getReturnVal(), 2);
+    rerun->reset();
+    work_queue.addWorkBlock(rerun);
+    EXPECT_EQ(rerun->getReturnVal(), 3);
+}
+
+TEST(work_queue, cancel_group)
+{
+    WorkQueue work_queue(1);
+    std::promise<void> gate;
+    work_queue.addTask([started = gate.get_future().share()] {
+        started.wait();
+    });
+
+    CancellationToken group;
+    std::atomic<int> count{0};
+    std::vector<std::shared_ptr<WorkBlock<void>>> blocks;
+    for (int ii = 0; ii < 100; ++ii) {
+        blocks.push_back(make_shared_workBlock([&count] { ++count; }));
+        work_queue.addWorkBlock(
+            blocks.back(), WorkQueue::WorkPriority::low, group);
+        work_queue.addTask(
+            [&count] { ++count; }, WorkQueue::WorkPriority::low, group);
+    }
+    auto other = make_shared_workBlock([&count] { ++count; });
+    work_queue.addWorkBlock(other, WorkQueue::WorkPriority::low);
+    EXPECT_FALSE(group.isCancelled());
+    group.cancel();
+    EXPECT_TRUE(group.isCancelled());
+    gate.set_value();
+
+    other->wait();
+    for (auto& block : blocks) {
+        EXPECT_THROW(block->get_future().get(), WorkCancelled);
+        EXPECT_TRUE(block->isCancelled());
+    }
+    EXPECT_EQ(count.load(), 1);
+}
+
+TEST(work_queue, metrics_compiled_out)
+{
+    if constexpr (WorkQueue::metricsEnabled) {
+        GTEST_SKIP() << "metrics are compiled in";
+    }
+    WorkQueue work_queue(1);
+    auto block = make_shared_workBlock([] { return 1; });
+    work_queue.addWorkBlock(block);
+    EXPECT_EQ(block->getReturnVal(), 1);
+    auto metrics = work_queue.getMetrics();
+    EXPECT_EQ(metrics[WorkQueue::WorkPriority::medium].queueWait.count, 0U);
+    EXPECT_EQ(metrics.utilization(), 0.0);
+    EXPECT_EQ(sizeof(WorkTask), 64U);
+}
+
+TEST(work_queue, batch_move)
+{
+    WorkQueue work_queue(2);
+    std::promise<void> gate;
+    auto started = gate.get_future().share();
+    auto blocker = make_shared_workBlock([started] { started.wait(); });
+    auto blocker2 = make_shared_workBlock([started] { started.wait(); });
+    work_queue.addWorkBlock(blocker, WorkQueue::WorkPriority::high);
+    work_queue.addWorkBlock(blocker2, WorkQueue::WorkPriority::high);
+    while (!work_queue.isEmpty()) {
+        std::this_thread::yield();
+    }
+
+    std::atomic<int> count{0};
+    auto finished = make_shared_workBlock([&count] { ++count; });
+    finished->execute();
+    std::vector<std::shared_ptr<BasicWorkBlock>> blocks;
+    std::vector<std::shared_ptr<WorkBlock<void>>> pending;
+    blocks.push_back(finished);
+    blocks.push_back(nullptr);
+    for (int ii = 0; ii < 10000; ++ii) {
+        pending.push_back(make_shared_workBlock([&count] { ++count; }));
+        blocks.push_back(pending.back());
+    }
+    work_queue.addWorkBlock(std::move(blocks), WorkQueue::WorkPriority::low);
+    EXPECT_TRUE(blocks.empty());
+    EXPECT_EQ(work_queue.numBlock(), 10000U);
+    EXPECT_EQ(pending.front().use_count(), 2);
+
+    // the copying overload skips finished blocks as well
+    std::vector<std::shared_ptr<BasicWorkBlock>> copies{finished, finished};
+    work_queue.addWorkBlock(copies);
+    EXPECT_EQ(copies.size(), 2U);
+    EXPECT_EQ(work_queue.numBlock(), 10000U);
+
+    gate.set_value();
+    for (auto& block : pending) {
+        block->wait();
+    }
+    EXPECT_EQ(count.load(), 10001);
+}
+
+TEST(work_queue, deadline_order)
+{
+    WorkQueue work_queue(1);
+    std::promise<void> gate;
+    auto blocker = make_shared_workBlock(
+        [started = gate.get_future().share()] { started.wait(); });
+    work_queue.addWorkBlock(blocker, WorkQueue::WorkPriority::high);
+    while (!work_queue.isEmpty()) {
+        std::this_thread::yield();
+    }
+
+    std::vector<int> order;
+    const auto now = std::chrono::steady_clock::now();
+    work_queue.addTask(
+        [&order] { order.push_back(0); }, WorkQueue::WorkPriority::medium);
+    for (int delay : {40, 10, 30, 10, 20}) {
+        work_queue.addDeadlineWork(
+            now + std::chrono::seconds(delay),
+            [&order, delay] { order.push_back(delay); });
+    }
+    auto block = make_shared_workBlock([&order] { order.push_back(5); });
+    work_queue.addDeadlineWork(now + std::chrono::seconds(5), block);
+    work_queue.addTask(
+        [&order] { order.push_back(1); }, WorkQueue::WorkPriority::high);
+    EXPECT_EQ(work_queue.numBlock(), 8U);
+
+    gate.set_value();
+    while (!work_queue.isEmpty()) {
+        std::this_thread::yield();
+    }
+    block->wait();
+    auto last = make_shared_workBlock([] {});
+    work_queue.addWorkBlock(last, WorkQueue::WorkPriority::low);
+    last->wait();
+    // high priority work first, then deadlines with ties in order of
+    // submission, then the medium priority work
+    EXPECT_EQ(order, (std::vector<int>{1, 5, 10, 10, 20, 30, 40, 0}));
+    auto counters = work_queue.getDeadlineCounters();
+    EXPECT_EQ(counters.completed, 6U);
+    EXPECT_EQ(counters.missed, 0U);
+    EXPECT_EQ(counters.lateStarts, 0U);
+}
+
+TEST(work_queue, deadline_misses)
+{
+    WorkQueue work_queue(1);
+    auto past = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+    auto late = make_shared_workBlock([] { return 7; });
+    work_queue.addDeadlineWork(past, late);
+    EXPECT_EQ(late->getReturnVal(), 7);
+
+    auto slow = make_shared_workBlock([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    });
+    work_queue.addDeadlineWork(
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(200),
+        slow);
+    slow->wait();
+    auto cancelled = make_shared_workBlock([] {});
+    cancelled->cancel();
+    work_queue.addDeadlineWork(past, cancelled);
+    // the counters are updated after the block has completed
+    auto last = make_shared_workBlock([] {});
+    work_queue.addWorkBlock(last, WorkQueue::WorkPriority::low);
+    last->wait();
+    auto counters = work_queue.getDeadlineCounters();
+    EXPECT_EQ(counters.completed, 2U);
+    EXPECT_EQ(counters.missed, 2U);
+    EXPECT_EQ(counters.lateStarts, 1U);
+}
+
+TEST(work_queue, deadline_no_workers)
+{
+    WorkQueue work_queue(0);
+    int value{0};
+    work_queue.addDeadlineWork(
+        std::chrono::steady_clock::now() + std::chrono::seconds(10),
+        [&value] { value = 3; });
+    EXPECT_EQ(value, 3);
+    EXPECT_EQ(work_queue.getDeadlineCounters().completed, 1U);
+}
+
+TEST(work_queue, nested_wait)
+{
+    // the only worker waits for work queued behind it, which blocked it
+    // forever before waits ran queued work
+    WorkQueue work_queue(1);
+    auto outer = make_shared_workBlock([&work_queue] {
+        auto inner = make_shared_workBlock([] { return 20; });
+        work_queue.addWorkBlock(inner, WorkQueue::WorkPriority::low);
+        auto other = make_shared_workBlock([] {});
+        work_queue.addWorkBlock(other, WorkQueue::WorkPriority::low);
+        other->wait();
+        return inner->getReturnVal() + 22;
+    });
+    work_queue.addWorkBlock(outer);
+    EXPECT_EQ(outer->getReturnVal(), 42);
+}
+
+namespace {
+int nestedLevels(WorkQueue& queue, int level, std::atomic<int>& deepest)
+{
+    int depth = gmlc::containers::detail::waitHelper().depth;
+    int seen = deepest.load();
+    while (depth > seen && !deepest.compare_exchange_weak(seen, depth)) {
+    }
+    if (level == 0) {
+        return 0;
+    }
+    auto child = make_shared_workBlock([&queue, level, &deepest] {
+        return nestedLevels(queue, level - 1, deepest);
+    });
+    queue.addWorkBlock(child);
+    return child->getReturnVal() + 1;
+}
+}  // namespace
+
+TEST(work_queue, nested_wait_depth)
+{
+    // each worker helps at most maxWaitHelpDepth levels deep and blocks
+    // below that, so three workers cover the twenty levels
+    WorkQueue work_queue(3);
+    std::atomic<int> deepest{0};
+    auto root = make_shared_workBlock([&work_queue, &deepest] {
+        return nestedLevels(work_queue, 20, deepest);
+    });
+    work_queue.addWorkBlock(root);
+    EXPECT_EQ(root->getReturnVal(), 20);
+    EXPECT_LE(deepest.load(), gmlc::containers::detail::maxWaitHelpDepth);
+    // the waiting thread is not a worker and did not run any of the work
+    EXPECT_EQ(gmlc::containers::detail::waitHelper().depth, 0);
+}
+
+TEST(work_queue, reserved_workers)
+{
+    using gmlc::containers::WorkerScaling;
+    auto scaling = WorkerScaling::fixed(2);
+    scaling.reservedWorkers = 1;
+    WorkQueue work_queue(scaling);
+    EXPECT_EQ(work_queue.getReservedWorkerCount(), 1);
+
+    std::promise<void> gate;
+    auto started = gate.get_future().share();
+    std::mutex lock;
+    std::vector<std::thread::id> lowThreads;
+    std::vector<std::shared_ptr<WorkBlock<void>>> blocks;
+    for (int ii = 0; ii < 3; ++ii) {
+        blocks.push_back(make_shared_workBlock([&, started] {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                lowThreads.push_back(std::this_thread::get_id());
+            }
+            started.wait();
+        }));
+        work_queue.addWorkBlock(
+            blocks.back(),
+            (ii == 0) ? WorkQueue::WorkPriority::medium :
+                        WorkQueue::WorkPriority::low);
+    }
+    // wait for the bulk worker to be stuck behind the gate
+    auto bulkStarted = [&] {
+        std::lock_guard<std::mutex> guard(lock);
+        return !lowThreads.empty();
+    };
+    while (!bulkStarted()) {
+        std::this_thread::yield();
+    }
+    // high work still runs on the reserved worker
+    for (int ii = 0; ii < 5; ++ii) {
+        auto high = make_shared_workBlock(
+            [] { return std::this_thread::get_id(); });
+        work_queue.addWorkBlock(high, WorkQueue::WorkPriority::high);
+        auto highThread = high->getReturnVal();
+        std::lock_guard<std::mutex> guard(lock);
+        ASSERT_EQ(lowThreads.size(), 1U);
+        EXPECT_NE(highThread, lowThreads.front());
+    }
+    gate.set_value();
+    for (auto& block : blocks) {
+        block->wait();
+    }
+    // all the bulk work ran on the one unreserved worker
+    EXPECT_EQ(lowThreads.size(), 3U);
+    EXPECT_EQ(lowThreads[1], lowThreads[0]);
+    EXPECT_EQ(lowThreads[2], lowThreads[0]);
+}
+
+TEST(work_queue, reserved_workers_parallel_for)
+{
+    using gmlc::containers::WorkerScaling;
+    auto scaling = WorkerScaling::fixed(2);
+    scaling.reservedWorkers = 1;
+    WorkQueue work_queue(scaling);
+
+    std::promise<void> gate;
+    auto blocker = make_shared_workBlock(
+        [started = gate.get_future().share()] { started.wait(); });
+    work_queue.addWorkBlock(blocker);
+    while (!work_queue.isEmpty()) {
+        std::this_thread::yield();
+    }
+    // the pieces are not queued as high priority work, so with the bulk
+    // worker busy the calling thread does the whole range
+    std::mutex lock;
+    std::vector<std::thread::id> threads;
+    work_queue.parallel_for(0, 200, 1, [&lock, &threads](int /*index*/) {
+        std::lock_guard<std::mutex> guard(lock);
+        threads.push_back(std::this_thread::get_id());
+    });
+    ASSERT_EQ(threads.size(), 200U);
+    for (const auto& thread : threads) {
+        EXPECT_EQ(thread, std::this_thread::get_id());
+    }
+    const auto sum = work_queue.parallel_reduce(
+        1, 101, 1, 0, std::plus<>(), WorkQueue::WorkPriority::low);
+    EXPECT_EQ(sum, 5050);
+    gate.set_value();
+    blocker->wait();
+}
+
+TEST(work_queue, reserved_workers_limits)
+{
+    using gmlc::containers::WorkerScaling;
+    auto scaling = WorkerScaling::fixed(1);
+    scaling.reservedWorkers = 1;
+    WorkQueue single(scaling);
+    EXPECT_EQ(single.getReservedWorkerCount(), 0);
+    auto block = make_shared_workBlock([] { return 2; });
+    single.addWorkBlock(block, WorkQueue::WorkPriority::low);
+    EXPECT_EQ(block->getReturnVal(), 2);
+
+    // at least one of the always running workers takes the other work
+    scaling = WorkerScaling::elastic(2, 4);
+    scaling.reservedWorkers = 3;
+    WorkQueue elastic(scaling);
+    EXPECT_EQ(elastic.getReservedWorkerCount(), 1);
+}
+
+TEST(work_queue, batched_tasks)
+{
+    WorkQueue work_queue(2);
+    work_queue.setBatchLimits(100, std::chrono::seconds(10));
+    std::promise<void> gate;
+    auto started = gate.get_future().share();
+    auto blocker = make_shared_workBlock([started] { started.wait(); });
+    auto blocker2 = make_shared_workBlock([started] { started.wait(); });
+    work_queue.addWorkBlock(blocker, WorkQueue::WorkPriority::high);
+    work_queue.addWorkBlock(blocker2, WorkQueue::WorkPriority::high);
+    while (!work_queue.isEmpty()) {
+        std::this_thread::yield();
+    }
+
+    std::vector<int> order;
+    for (int ii = 0; ii < 250; ++ii) {
+        work_queue.addBatchedTask([&order, ii] { order.push_back(ii); });
+    }
+    // two full blocks are queued and the rest stays buffered
+    EXPECT_EQ(work_queue.numBlock(), 2U);
+    work_queue.flushBatches();
+    EXPECT_EQ(work_queue.numBlock(), 3U);
+    work_queue.flushBatches();
+    EXPECT_EQ(work_queue.numBlock(), 3U);
+
+    // run the blocks in order on this thread, each one runs all its tasks
+    for (int block = 0; block < 3; ++block) {
+        auto task = work_queue.getTask();
+        ASSERT_TRUE(task);
+        task();
+        EXPECT_EQ(
+            order.size(), std::min<std::size_t>(100U * (block + 1), 250U));
+    }
+    for (int ii = 0; ii < 250; ++ii) {
+        EXPECT_EQ(order[ii], ii);
+    }
+    gate.set_value();
+}
+
+TEST(work_queue, batched_tasks_idle_flush)
+{
+    // the buffered tasks are run after the delay, without a flush
+    WorkQueue work_queue(1);
+    work_queue.setBatchLimits(1000, std::chrono::milliseconds(5));
+    std::atomic<int> count{0};
+    for (int ii = 0; ii < 10; ++ii) {
+        work_queue.addBatchedTask(
+            [&count] { ++count; }, WorkQueue::WorkPriority::low);
+    }
+    while (count.load() < 10) {
+        std::this_thread::yield();
+    }
+
+    // and from other threads
+    std::thread submitter([&work_queue, &count] {
+        for (int ii = 0; ii < 10000; ++ii) {
+            work_queue.addBatchedTask([&count] { ++count; });
+        }
+    });
+    submitter.join();
+    while (count.load() < 10010) {
+        std::this_thread::yield();
+    }
+
+    // a worker waiting on a block flushes the tasks it is waiting for
+    auto outer = make_shared_workBlock([&work_queue] {
+        auto inner = make_shared_workBlock([] { return 3; });
+        work_queue.addBatchedTask([inner] { inner->execute(); });
+        return inner->getReturnVal();
+    });
+    work_queue.addWorkBlock(outer);
+    EXPECT_EQ(outer->getReturnVal(), 3);
+}
+
+TEST(work_queue, batched_tasks_idle_workers)
+{
+    // a burst is held in one block instead of waking the idle workers
+    WorkQueue work_queue(2);
+    work_queue.setBatchLimits(1000, std::chrono::seconds(10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::atomic<int> count{0};
+    for (int ii = 0; ii < 100; ++ii) {
+        work_queue.addBatchedTask([&count] { ++count; });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(count.load(), 0);
+    EXPECT_EQ(work_queue.numBlock(), 0U);
+    work_queue.flushBatches();
+    while (count.load() < 100) {
+        std::this_thread::yield();
+    }
+
+    // full blocks wake the workers, which take the rest once they are done
+    work_queue.setBatchLimits(25, std::chrono::seconds(10));
+    for (int ii = 0; ii < 110; ++ii) {
+        work_queue.addBatchedTask([&count] { ++count; });
+    }
+    while (count.load() < 210) {
+        std::this_thread::yield();
+    }
+}
+
+TEST(work_queue, batched_tasks_delay)
+{
+    WorkQueue work_queue(1);
+    work_queue.setBatchLimits(1000000, std::chrono::milliseconds(1));
+    std::promise<void> gate;
+    auto blocker = make_shared_workBlock(
+        [started = gate.get_future().share()] { started.wait(); });
+    work_queue.addWorkBlock(blocker, WorkQueue::WorkPriority::high);
+    while (!work_queue.isEmpty()) {
+        std::this_thread::yield();
+    }
+    std::atomic<int> count{0};
+    // the timer queues a partial block while the worker is busy
+    for (int ii = 0; ii < 3; ++ii) {
+        work_queue.addBatchedTask([&count] { ++count; });
+    }
+    while (work_queue.numBlock() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(work_queue.numBlock(), 1U);
+    EXPECT_EQ(count.load(), 0);
+    gate.set_value();
+    while (count.load() < 3) {
+        std::this_thread::yield();
+    }
+}
+
+TEST(work_queue, batched_tasks_thread_exit)
+{
+    // the buffers of threads that exited are released, their tasks still run
+    WorkQueue work_queue(1);
+    work_queue.setBatchLimits(1000, std::chrono::seconds(10));
+    std::atomic<int> count{0};
+    for (int ii = 0; ii < 50; ++ii) {
+        std::thread submitter([&work_queue, &count] {
+            for (int jj = 0; jj < 5; ++jj) {
+                work_queue.addBatchedTask([&count] { ++count; });
+            }
+        });
+        submitter.join();
+        work_queue.flushBatches();
+        EXPECT_LE(work_queue.numBatchBuffers(), 1U);
+    }
+    while (count.load() < 250) {
+        std::this_thread::yield();
+    }
+}
+
+TEST(work_queue, task_memory)
+{
+    EXPECT_EQ(WorkQueue::taskMemory(), std::pmr::get_default_resource());
+    WorkQueue work_queue(1);
+    auto allocate = [] {
+        auto* memory = WorkQueue::taskMemory();
+        std::pmr::vector<int> values(memory);
+        values.reserve(100);
+        values.push_back(1);
+        return std::make_pair(memory, static_cast<const void*>(values.data()));
+    };
+    auto first = make_shared_workBlock(allocate);
+    work_queue.addWorkBlock(first);
+    auto [firstMemory, firstData] = first->getReturnVal();
+    EXPECT_NE(firstMemory, std::pmr::get_default_resource());
+
+    // the arena is reset after each task so the next one reuses the memory
+    auto second = make_shared_workBlock(allocate);
+    work_queue.addWorkBlock(second);
+    auto [secondMemory, secondData] = second->getReturnVal();
+    EXPECT_EQ(secondMemory, firstMemory);
+    EXPECT_EQ(secondData, firstData);
+
+    // work run while a task waits does not reset the waiting task's memory
+    auto nested = make_shared_workBlock([&work_queue, allocate] {
+        std::pmr::vector<int> values(WorkQueue::taskMemory());
+        values.assign(1000, 7);
+        auto inner = make_shared_workBlock(allocate);
+        work_queue.addWorkBlock(inner);
+        inner->wait();
+        // after a reset this would reuse the memory of values
+        std::pmr::vector<int> more(WorkQueue::taskMemory());
+        more.assign(1000, 3);
+        return values[999] == 7;
+    });
+    work_queue.addWorkBlock(nested);
+    EXPECT_TRUE(nested->getReturnVal());
+}
+
+TEST(work_queue, task_memory_disabled)
+{
+    auto scaling = gmlc::containers::WorkerScaling::fixed(1);
+    scaling.taskArenaSize = 0;
+    WorkQueue work_queue(scaling);
+    auto block = make_shared_workBlock([] { return WorkQueue::taskMemory(); });
+    work_queue.addWorkBlock(block);
+    EXPECT_EQ(block->getReturnVal(), std::pmr::get_default_resource());
+}
+
+TEST(work_queue, tracing_compiled_out)
+{
+    if constexpr (WorkQueue::tracingEnabled) {
+        GTEST_SKIP() << "tracing is compiled in";
+    }
+    WorkQueue work_queue(1);
+    auto block = make_shared_workBlock([] {});
+    work_queue.addWorkBlock(block);
+    block->wait();
+    std::ostringstream out;
+    work_queue.writeTrace(out);
+    EXPECT_EQ(out.str(), "{\"traceEvents\":[\n],\"displayTimeUnit\":\"ns\"}\n");
+}
@@ -0,0 +1,163 @@
+/*
+Copyright (c) 2017-2026,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "WorkQueue.hpp"
+
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using gmlc::containers::make_shared_workBlock;
+using gmlc::containers::WorkQueue;
+
+static_assert(WorkQueue::tracingEnabled, "tracing must be compiled in");
+
+namespace {
+std::size_t countOf(const std::string& text, const std::string& pattern)
+{
+    std::size_t count{0};
+    for (auto pos = text.find(pattern); pos != std::string::npos;
+         pos = text.find(pattern, pos + pattern.size())) {
+        ++count;
+    }
+    return count;
+}
+
+/** get the times of the async events of one phase by their id*/
+std::map<std::string, double>
+    asyncTimes(const std::string& text, const std::string& phase)
+{
+    std::map<std::string, double> times;
+    const std::string pattern = R"("ph":")" + phase + '"';
+    for (auto pos = text.find(pattern); pos != std::string::npos;
+         pos = text.find(pattern, pos + pattern.size())) {
+        const auto id = text.find("\"id\":", pos) + 5;
+        const auto time = text.find("\"ts\":", pos) + 5;
+        times[text.substr(id, text.find(',', id) - id)] =
+            std::stod(text.substr(time));
+    }
+    return times;
+}
+}  // namespace
+
+TEST(work_queue_tracing, chrome_trace)
+{
+    WorkQueue work_queue(2);
+    std::atomic<int> count{0};
+    for (int ii = 0; ii < 10000; ++ii) {
+        work_queue.addTask(
+            [&count] { ++count; },
+            (ii % 2 == 0) ? WorkQueue::WorkPriority::low :
+                            WorkQueue::WorkPriority::high);
+    }
+    auto last = make_shared_workBlock([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    });
+    work_queue.addWorkBlock(last);
+    last->wait();
+    while (count.load() < 10000) {
+        std::this_thread::yield();
+    }
+    // the block's event is recorded after its future is ready
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    std::ostringstream out;
+    work_queue.writeTrace(out);
+    const auto trace = out.str();
+    EXPECT_EQ(trace.rfind("{\"traceEvents\":[", 0), 0U);
+    EXPECT_EQ(countOf(trace, R"("ph":"M")"), 2U);
+    EXPECT_EQ(countOf(trace, R"("ph":"X")"), 10001U);
+    EXPECT_EQ(countOf(trace, R"("ph":"b")"), 10001U);
+    EXPECT_EQ(countOf(trace, R"("ph":"e")"), 10001U);
+    EXPECT_EQ(countOf(trace, R"({"name":"low","cat":"task")"), 5000U);
+    EXPECT_EQ(countOf(trace, R"({"name":"high","cat":"task")"), 5000U);
+    EXPECT_EQ(countOf(trace, R"({"name":"medium","cat":"task")"), 1U);
+    EXPECT_EQ(countOf(trace, "{"), countOf(trace, "}"));
+    // the sleeping block lasted at least 2 ms
+    EXPECT_NE(
+        trace.find(R"({"name":"medium","cat":"task","ph":"X")"),
+        std::string::npos);
+    const auto block = trace.find(R"({"name":"medium","cat":"task")");
+    const auto duration = trace.find("\"dur\":", block);
+    ASSERT_NE(duration, std::string::npos);
+    EXPECT_GE(std::stod(trace.substr(duration + 6)), 2000.0);
+}
+
+TEST(work_queue_tracing, start_after_queued)
+{
+    // tasks trickling in are queued after the previous task of the worker
+    // ended, each one still starts after it was queued
+    WorkQueue work_queue(1);
+    std::atomic<int> count{0};
+    for (int ii = 0; ii < 2000; ++ii) {
+        work_queue.addTask([&count] { ++count; });
+        if (ii % 8 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    while (count.load() < 2000) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    std::ostringstream out;
+    work_queue.writeTrace(out);
+    const auto queued = asyncTimes(out.str(), "b");
+    const auto started = asyncTimes(out.str(), "e");
+    ASSERT_EQ(queued.size(), 2000U);
+    ASSERT_EQ(started.size(), 2000U);
+    for (const auto& [id, time] : queued) {
+        EXPECT_GE(started.at(id), time) << "task " << id;
+    }
+}
+
+TEST(work_queue_tracing, switched_off)
+{
+    WorkQueue work_queue(1);
+    work_queue.setTracing(false);
+    auto hidden = make_shared_workBlock([] {});
+    work_queue.addWorkBlock(hidden);
+    hidden->wait();
+    // the event of a block is recorded after its future is ready
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    work_queue.setTracing(true);
+    auto shown = make_shared_workBlock([] {});
+    work_queue.addWorkBlock(shown);
+    shown->wait();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    std::ostringstream out;
+    work_queue.writeTrace(out);
+    EXPECT_EQ(countOf(out.str(), R"("ph":"X")"), 1U);
+}
+
+TEST(work_queue_tracing, bounded)
+{
+    // the oldest events are overwritten once a worker's buffer is full
+    constexpr auto capacity = gmlc::containers::detail::TraceBuffer::capacity;
+    constexpr int taskCount = static_cast<int>(capacity) * 2;
+    WorkQueue work_queue(1);
+    std::atomic<int> count{0};
+    for (int ii = 0; ii < taskCount; ++ii) {
+        work_queue.addTask([&count] { ++count; });
+    }
+    while (count.load() < taskCount) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    std::ostringstream out;
+    work_queue.writeTrace(out);
+    const auto events = countOf(out.str(), R"("ph":"X")");
+    EXPECT_LE(events, capacity);
+    EXPECT_GE(events, capacity / 2);
+}